@@ -0,0 +1,21 @@
+#ifndef UNPACKER_CORE_BENCHMARKS_ALLOCATION_COUNTER_H
+#define UNPACKER_CORE_BENCHMARKS_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// Counts calls to the global operator new made by this process. The benchmark executable
+// replaces operator new, so library and ROOT allocations are included.
+class AllocationCounter {
+public:
+    AllocationCounter() : start_(Total()) {}
+
+    size_t Count() const { return Total() - start_; }
+    void Reset() { start_ = Total(); }
+
+    static size_t Total();
+
+private:
+    size_t start_;
+};
+
+#endif // UNPACKER_CORE_BENCHMARKS_ALLOCATION_COUNTER_H
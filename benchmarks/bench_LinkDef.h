@@ -0,0 +1,10 @@
+// bench_LinkDef.h
+#ifdef __CINT__
+#pragma link off all globals;
+#pragma link off all classes;
+#pragma link off all functions;
+
+#pragma link C++ class BenchScalarRecord+;
+#pragma link C++ class BenchArrayRecord+;
+
+#endif
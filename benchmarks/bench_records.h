@@ -0,0 +1,46 @@
+#ifndef UNPACKER_CORE_BENCHMARKS_BENCH_RECORDS_H
+#define UNPACKER_CORE_BENCHMARKS_BENCH_RECORDS_H
+
+#include <TObject.h>
+
+#include <array>
+
+/// Scalar-heavy record: many small header fields of mixed width
+class BenchScalarRecord : public TObject {
+public:
+    BenchScalarRecord() = default;
+    ~BenchScalarRecord() override = default;
+
+    unsigned int run = 0;
+    unsigned int event = 0;
+    unsigned short crate = 0;
+    unsigned short slot = 0;
+    unsigned short channel = 0;
+    unsigned short flags = 0;
+    int tdc = 0;
+    int adc = 0;
+    Long64_t timestamp = 0;
+    float energy = 0;
+    float time = 0;
+    double charge = 0;
+    unsigned char quality = 0;
+
+    ClassDefOverride(BenchScalarRecord, 1);
+};
+
+/// Array-heavy record: a digitizer waveform with a short header and fit results
+class BenchArrayRecord : public TObject {
+public:
+    BenchArrayRecord() = default;
+    ~BenchArrayRecord() override = default;
+
+    unsigned int header = 0;
+    unsigned short channel = 0;
+    std::array<unsigned short, 128> samples{};
+    std::array<float, 8> fit{};
+    unsigned int trailer = 0;
+
+    ClassDefOverride(BenchArrayRecord, 1);
+};
+
+#endif // UNPACKER_CORE_BENCHMARKS_BENCH_RECORDS_H
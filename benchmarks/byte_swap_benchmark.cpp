@@ -0,0 +1,65 @@
+// Compares the dispatched ByteSwap array kernels against the per-element
+// memcpy + byte-reversal loop TypeRegistry used for big-endian arrays.
+
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void LegacySwapArray(void* dst, const void* src, size_t element_size, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* out = static_cast<uint8_t*>(dst) + i * element_size;
+        std::memcpy(out, static_cast<const uint8_t*>(src) + i * element_size, element_size);
+        for (size_t b = 0; b < element_size / 2; ++b) {
+            std::swap(out[b], out[element_size - 1 - b]);
+        }
+    }
+}
+
+template<typename SwapFn>
+void RunSwap(benchmark::State& state, SwapFn&& swap) {
+    const size_t element_size = static_cast<size_t>(state.range(0));
+    const size_t count = static_cast<size_t>(state.range(1));
+
+    std::vector<uint8_t> src(element_size * count);
+    std::vector<uint8_t> dst(src.size());
+    std::mt19937 rng(42);
+    std::generate(src.begin(), src.end(), [&rng] { return static_cast<uint8_t>(rng()); });
+
+    for (auto _ : state) {
+        swap(dst.data(), src.data(), element_size, count);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(count));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(src.size()));
+}
+
+void BM_ByteSwapLegacy(benchmark::State& state) {
+    RunSwap(state, LegacySwapArray);
+}
+
+void BM_ByteSwapKernel(benchmark::State& state) {
+    state.SetLabel(ByteSwap::ActiveKernelName());
+    RunSwap(state, [](void* dst, const void* src, size_t element_size, size_t count) {
+        ByteSwap::SwapArray(dst, src, element_size, count);
+    });
+}
+
+void SwapArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"width", "elements"});
+    b->ArgsProduct({{2, 4, 8}, {64, 1024, 65536}});
+}
+
+} // namespace
+
+BENCHMARK(BM_ByteSwapLegacy)->Apply(SwapArgs);
+BENCHMARK(BM_ByteSwapKernel)->Apply(SwapArgs);
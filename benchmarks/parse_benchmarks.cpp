@@ -0,0 +1,184 @@
+// Parse throughput of the unpacker hot paths on synthetic record buffers.
+//
+// Every benchmark takes {record count, big endian} arguments and reports:
+//   items_per_second   records decoded per second
+//   bytes_per_second   encoded bytes consumed per second
+//   allocs_per_record  global operator new calls per decoded record
+//   time_per_field     seconds per mapped field
+
+#include "allocation_counter.h"
+#include "bench_records.h"
+
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+#include "analysis_pipeline/unpacker_core/utils/field_mapping_parser.h"
+#include "analysis_pipeline/unpacker_core/utils/record_view.h"
+#include "analysis_pipeline/unpacker_core/utils/reflection_based_parser.h"
+#include "analysis_pipeline/unpacker_core/utils/type_registry.h"
+
+#include <TClass.h>
+#include <TClonesArray.h>
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+// One encoded record per stride, filled with random bytes so no value is special
+struct Workload {
+    explicit Workload(const benchmark::State& state, const char* class_name)
+        : count(static_cast<size_t>(state.range(0))),
+          parser(class_name, state.range(1) ? "big" : "little"),
+          stride(parser.GetTotalParsedSize()),
+          buffer(stride * count) {
+        std::mt19937 rng(1234);
+        std::generate(buffer.begin(), buffer.end(), [&rng] { return static_cast<uint8_t>(rng()); });
+    }
+
+    size_t count;
+    ReflectionBasedParser parser;
+    size_t stride;
+    std::vector<uint8_t> buffer;
+};
+
+void ReportThroughput(benchmark::State& state, const Workload& w, size_t allocations) {
+    const auto records = static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(w.count);
+    const size_t fields = w.parser.GetPlan()->GetFields().size();
+
+    state.SetItemsProcessed(records);
+    state.SetBytesProcessed(records * static_cast<int64_t>(w.stride));
+    state.counters["allocs_per_record"] =
+        records ? static_cast<double>(allocations) / static_cast<double>(records) : 0.0;
+    state.counters["time_per_field"] = benchmark::Counter(static_cast<double>(w.count * fields),
+                                                          benchmark::Counter::kIsIterationInvariantRate |
+                                                          benchmark::Counter::kInvert);
+}
+
+// ReflectionBasedParser::Parse into a reused TClonesArray, the path stages normally take
+template<typename Record>
+void BM_ReflectionParse(benchmark::State& state) {
+    Workload w(state, Record::Class_Name());
+    TClonesArray out(Record::Class(), static_cast<Int_t>(w.count));
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        for (size_t i = 0; i < w.count; ++i) {
+            TObject* obj = out.ConstructedAt(static_cast<Int_t>(i), "C");
+            if (!w.parser.Parse(w.buffer.data(), w.buffer.size(), i * w.stride, obj)) {
+                state.SkipWithError("Parse failed");
+                return;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    ReportThroughput(state, w, allocations.Count());
+}
+
+// FieldMappingParser::ParseAndFill with a JSON mapping, including the plan cache lookup
+template<typename Record>
+void BM_FieldMappingParse(benchmark::State& state) {
+    Workload w(state, Record::Class_Name());
+    const nlohmann::json& mapping = w.parser.GetFieldMapping();
+    FieldMappingParser parser;
+    TClonesArray out(Record::Class(), static_cast<Int_t>(w.count));
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        for (size_t i = 0; i < w.count; ++i) {
+            TObject* obj = out.ConstructedAt(static_cast<Int_t>(i), "C");
+            if (!parser.ParseAndFill(w.buffer.data(), w.buffer.size(), i * w.stride, mapping, obj)) {
+                state.SkipWithError("ParseAndFill failed");
+                return;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    ReportThroughput(state, w, allocations.Count());
+}
+
+// One TypeRegistry handler call per field, as decoding worked before mappings were compiled.
+// The gap to BM_ReflectionParse is the per-field dispatch cost the compiled plan removes.
+template<typename Record>
+void BM_HandlerPerField(benchmark::State& state) {
+    Workload w(state, Record::Class_Name());
+    const TypeRegistry& registry = TypeRegistry::Instance();
+
+    struct Field {
+        TypeRegistry::HandlerFunc handler;
+        TDataMember* member;
+        size_t offset;
+        bool little_endian;
+    };
+    std::vector<Field> fields;
+    for (const auto& op : w.parser.GetPlan()->GetFields()) {
+        fields.push_back({registry.GetHandler(op.member->GetTypeName()), op.member,
+                          static_cast<size_t>(op.source_offset), op.little_endian});
+    }
+
+    TClonesArray out(Record::Class(), static_cast<Int_t>(w.count));
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        for (size_t i = 0; i < w.count; ++i) {
+            TObject* obj = out.ConstructedAt(static_cast<Int_t>(i), "C");
+            for (const Field& f : fields) {
+                if (!f.handler(w.buffer.data(), w.buffer.size(), i * w.stride + f.offset, f.little_endian, obj, f.member)) {
+                    state.SkipWithError("Handler failed");
+                    return;
+                }
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    ReportThroughput(state, w, allocations.Count());
+}
+
+// Lazy access: one field read per record through a RecordView, no objects built
+template<typename Record>
+void BM_RecordViewField(benchmark::State& state) {
+    Workload w(state, Record::Class_Name());
+    const CompiledParsePlan* plan = w.parser.GetPlan().get();
+    const size_t field = plan->FindField("channel");
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < w.count; ++i) {
+            unsigned short channel = 0;
+            RecordView view(plan, w.buffer.data(), w.buffer.size(), i * w.stride);
+            if (!view.Get(field, channel)) {
+                state.SkipWithError("RecordView::Get failed");
+                return;
+            }
+            sum += channel;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    ReportThroughput(state, w, allocations.Count());
+}
+
+// Record counts x {little, big} endian
+void ParseArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"records", "big_endian"});
+    b->ArgsProduct({{64, 1024, 16384}, {0, 1}});
+}
+
+// The parsers log at info level on construction; keep the benchmark output readable
+const bool kQuietLogs = [] {
+    spdlog::set_level(spdlog::level::warn);
+    return true;
+}();
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ReflectionParse, BenchScalarRecord)->Apply(ParseArgs);
+BENCHMARK_TEMPLATE(BM_ReflectionParse, BenchArrayRecord)->Apply(ParseArgs);
+BENCHMARK_TEMPLATE(BM_FieldMappingParse, BenchScalarRecord)->Apply(ParseArgs);
+BENCHMARK_TEMPLATE(BM_FieldMappingParse, BenchArrayRecord)->Apply(ParseArgs);
+BENCHMARK_TEMPLATE(BM_HandlerPerField, BenchScalarRecord)->Apply(ParseArgs);
+BENCHMARK_TEMPLATE(BM_HandlerPerField, BenchArrayRecord)->Apply(ParseArgs);
+BENCHMARK_TEMPLATE(BM_RecordViewField, BenchScalarRecord)->Apply(ParseArgs);
+BENCHMARK_TEMPLATE(BM_RecordViewField, BenchArrayRecord)->Apply(ParseArgs);
@@ -5,6 +5,13 @@
 #pragma link off all functions;
 
 #pragma link C++ class ByteStreamProcessorStage+;
+#pragma link C++ class PooledObjectCollection+;
+#pragma link C++ class RecordViewCollection+;
+#pragma link C++ class StageMetricsSummary+;
+#pragma link C++ class PacketIndex+;
+#pragma link C++ class ColumnarRecordBatch+;
+#pragma link C++ class MappedByteStream+;
+#pragma link C++ class ByteStreamFileReplayStage+;
 
 
 #endif
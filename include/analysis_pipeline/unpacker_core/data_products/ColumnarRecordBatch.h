@@ -0,0 +1,79 @@
+#ifndef ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_COLUMNAR_RECORD_BATCH_H
+#define ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_COLUMNAR_RECORD_BATCH_H
+
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+
+#include <TObject.h>
+#include <TClass.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Data product holding a batch of decoded records as one column per mapped field
+/// (structure of arrays) instead of one TObject per record. Each column is contiguous,
+/// 64-byte aligned and in host byte order; array<T,N> fields store N elements per record.
+/// Stages that sweep one field across all hits read it with GetColumn<T>().
+/// The batch is transient: its columns are not streamed, so an output stage persisting it
+/// writes an empty object. Products meant for output should be decoded into a
+/// TClonesArray with parseRecordsFromBytes instead.
+class ColumnarRecordBatch : public TObject {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    struct Column {
+        std::string name;
+        size_t element_size = 0;
+        size_t elements_per_record = 1;
+        size_t offset = 0;  // into the batch storage
+    };
+
+    ColumnarRecordBatch() = default;
+    ~ColumnarRecordBatch() override = default;
+
+    /// Lays out one column per field of the plan for `records` records. Storage is kept
+    /// across calls, so a batch refilled every event stops allocating once it is big enough.
+    void Reset(std::shared_ptr<const CompiledParsePlan> plan, size_t records);
+
+    size_t GetEntries() const { return records_; }
+    size_t GetColumnCount() const { return columns_.size(); }
+    const Column& GetColumnInfo(size_t index) const { return columns_[index]; }
+
+    /// Column index for GetColumn, or CompiledParsePlan::kNoField
+    size_t FindColumn(const std::string& name) const;
+
+    /// Typed column of GetEntries() * elements_per_record values, or nullptr if T does not
+    /// have the column's element size
+    template<typename T>
+    const T* GetColumn(size_t index) const {
+        if (index >= columns_.size() || columns_[index].element_size != sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(storage_.get() + columns_[index].offset);
+    }
+
+    uint8_t* GetColumnData(size_t index) { return storage_.get() + columns_[index].offset; }
+
+    const CompiledParsePlan* GetPlan() const { return plan_.get(); }
+    TClass* GetRecordClass() const { return plan_ ? plan_->GetClass() : nullptr; }
+
+    void Clear(Option_t* option = "") override;
+
+private:
+    struct FreeDeleter {
+        void operator()(uint8_t* p) const { std::free(p); }
+    };
+
+    std::shared_ptr<const CompiledParsePlan> plan_;  //!
+    std::vector<Column> columns_;                    //!
+    std::unique_ptr<uint8_t, FreeDeleter> storage_;  //!
+    size_t capacity_ = 0;                            //!
+    size_t records_ = 0;                             //!
+
+    ClassDefOverride(ColumnarRecordBatch, 1);
+};
+
+#endif // ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_COLUMNAR_RECORD_BATCH_H
@@ -0,0 +1,44 @@
+#ifndef ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_MAPPED_BYTE_STREAM_H
+#define ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_MAPPED_BYTE_STREAM_H
+
+#include "analysis_pipeline/unpacker_core/utils/mapped_file.h"
+
+#include <TObject.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+/// Zero-copy ByteStream bank: a view of `size` bytes of a memory-mapped file. Processor
+/// stages decode straight from the page cache; the view holds the mapping open for as long
+/// as it, or any product copied from it, is alive. The view is transient and is not written
+/// out with the event.
+class MappedByteStream : public TObject {
+public:
+    MappedByteStream() = default;
+    MappedByteStream(std::shared_ptr<const MappedFile> file, size_t offset, size_t size);
+    ~MappedByteStream() override = default;
+
+    const uint8_t* GetData() const { return file_ ? file_->Data() + offset_ : nullptr; }
+    size_t GetSize() const { return size_; }
+
+    /// The mapping, for consumers that keep the bytes beyond the product's lifetime
+    const std::shared_ptr<const MappedFile>& GetFile() const { return file_; }
+
+    /// Where the bank starts in its file, for provenance and resuming replays
+    const std::string& GetSourcePath() const;
+    uint64_t GetFileOffset() const { return offset_; }
+
+    void Clear(Option_t* option = "") override;
+
+private:
+    std::shared_ptr<const MappedFile> file_;  //!
+    uint64_t offset_ = 0;                     //!
+    uint64_t size_ = 0;                       //!
+
+    ClassDefOverride(MappedByteStream, 1);
+};
+
+#endif // ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_MAPPED_BYTE_STREAM_H
@@ -0,0 +1,47 @@
+#ifndef ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_PACKET_INDEX_H
+#define ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_PACKET_INDEX_H
+
+#include "analysis_pipeline/unpacker_core/utils/packet_framing.h"
+
+#include <TObject.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Data product with the offset and length of every complete record in a ByteStream bank,
+/// found by one PacketScanner pass. Downstream stages seek straight to the records they
+/// need, or split them across threads, instead of each re-scanning the bank.
+class PacketIndex : public TObject {
+public:
+    PacketIndex() = default;
+    ~PacketIndex() override = default;
+
+    /// Replaces the index with a scan of data from start_offset
+    void Build(const uint8_t* data, size_t data_size, size_t start_offset, const PacketFraming& framing);
+
+    /// Records are in stream order, so offsets ascend
+    size_t GetEntries() const { return offsets_.size(); }
+    uint64_t GetOffset(size_t index) const { return offsets_[index]; }
+    uint32_t GetLength(size_t index) const { return lengths_[index]; }
+
+    const std::vector<uint64_t>& GetOffsets() const { return offsets_; }
+    const std::vector<uint32_t>& GetLengths() const { return lengths_; }
+
+    /// First byte after the last complete record; a truncated trailing record starts here
+    uint64_t GetEndOffset() const { return end_offset_; }
+    /// Bytes passed over while resynchronizing on the header magic
+    uint64_t GetSkippedBytes() const { return skipped_bytes_; }
+
+    void Clear(Option_t* option = "") override;
+
+private:
+    std::vector<uint64_t> offsets_;
+    std::vector<uint32_t> lengths_;
+    uint64_t end_offset_ = 0;
+    uint64_t skipped_bytes_ = 0;
+
+    ClassDefOverride(PacketIndex, 1);
+};
+
+#endif // ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_PACKET_INDEX_H
@@ -0,0 +1,34 @@
+#ifndef ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_POOLED_OBJECT_COLLECTION_H
+#define ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_POOLED_OBJECT_COLLECTION_H
+
+#include "analysis_pipeline/unpacker_core/utils/object_pool.h"
+
+#include <TObject.h>
+
+#include <cstddef>
+#include <vector>
+
+/// Data product holding decoded objects borrowed from an ObjectPool. When the product
+/// is cleared or destroyed by the data product manager, the objects go back to their
+/// pool for the next event instead of being freed.
+class PooledObjectCollection : public TObject {
+public:
+    PooledObjectCollection() = default;
+    ~PooledObjectCollection() override = default;
+
+    void Add(PooledObject obj);
+    void Reserve(size_t count) { objects_.reserve(count); }
+
+    TObject* At(size_t index) const { return objects_[index].get(); }
+    size_t GetEntries() const { return objects_.size(); }
+
+    /// Returns every held object to its pool
+    void Clear(Option_t* option = "") override;
+
+private:
+    std::vector<PooledObject> objects_;  //! owned through their pool's recycler
+
+    ClassDefOverride(PooledObjectCollection, 1);
+};
+
+#endif // ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_POOLED_OBJECT_COLLECTION_H
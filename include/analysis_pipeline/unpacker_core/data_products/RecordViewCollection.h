@@ -0,0 +1,59 @@
+#ifndef ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_RECORD_VIEW_COLLECTION_H
+#define ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_RECORD_VIEW_COLLECTION_H
+
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+#include "analysis_pipeline/unpacker_core/utils/record_view.h"
+
+#include <TObject.h>
+#include <TClass.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Data product exposing undecoded records as lazy RecordViews over an input buffer.
+/// Downstream stages resolve the fields they need once with FindField() and read them per
+/// record; only records they keep need to be materialized into objects. The collection
+/// holds a reference to whatever owns the bytes, so views stay valid as long as it lives,
+/// also after the producer has moved on to the next bank.
+class RecordViewCollection : public TObject {
+public:
+    RecordViewCollection() = default;
+
+    /// Views into buffer without a copy; owner (an IngestRing bank's owner, a MappedFile, ...)
+    /// must keep [buffer, buffer + buffer_size) alive and unchanged
+    RecordViewCollection(std::shared_ptr<const CompiledParsePlan> plan,
+                         std::shared_ptr<const void> owner,
+                         const uint8_t* buffer,
+                         size_t buffer_size);
+
+    /// Copies [buffer, buffer + buffer_size), for buffers nothing shared owns, such as a
+    /// ByteStream read under a lock
+    RecordViewCollection(std::shared_ptr<const CompiledParsePlan> plan, const uint8_t* buffer, size_t buffer_size);
+    ~RecordViewCollection() override = default;
+
+    void AddRecord(size_t start_offset) { offsets_.push_back(start_offset); }
+    void AddRecords(size_t start_offset, size_t stride, size_t count);
+
+    size_t GetEntries() const { return offsets_.size(); }
+    RecordView At(size_t index) const { return RecordView(plan_.get(), buffer_, buffer_size_, offsets_[index]); }
+
+    /// Field index for RecordView::Get, or CompiledParsePlan::kNoField
+    size_t FindField(const std::string& name) const;
+    TClass* GetRecordClass() const { return plan_ ? plan_->GetClass() : nullptr; }
+
+    void Clear(Option_t* option = "") override;
+
+private:
+    std::shared_ptr<const CompiledParsePlan> plan_;  //!
+    std::shared_ptr<const void> owner_;              //! keeps buffer_ alive
+    const uint8_t* buffer_ = nullptr;                //!
+    size_t buffer_size_ = 0;                         //!
+    std::vector<size_t> offsets_;                    //!
+
+    ClassDefOverride(RecordViewCollection, 2);
+};
+
+#endif // ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_RECORD_VIEW_COLLECTION_H
@@ -0,0 +1,56 @@
+#ifndef ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_STAGE_METRICS_SUMMARY_H
+#define ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_STAGE_METRICS_SUMMARY_H
+
+#include "analysis_pipeline/unpacker_core/utils/stage_metrics.h"
+
+#include <TObject.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+/// Data product with a stage's hot-path counters, summed over the events since it was last
+/// published. ByteStreamProcessorStage publishes one every "publish_every_events" events.
+class StageMetricsSummary : public TObject {
+public:
+    StageMetricsSummary() = default;
+    explicit StageMetricsSummary(std::string stage_name) : stage_name_(std::move(stage_name)) {}
+    ~StageMetricsSummary() override = default;
+
+    void Add(const StageMetrics::Totals& totals, ULong64_t events);
+
+    const std::string& GetStageName() const { return stage_name_; }
+    ULong64_t GetEvents() const { return events_; }
+    ULong64_t GetBytesConsumed() const { return bytes_consumed_; }
+    ULong64_t GetRecordsDecoded() const { return records_decoded_; }
+    ULong64_t GetDecodeFailures() const { return decode_failures_; }
+    ULong64_t GetLockWaitNs() const { return lock_wait_ns_; }
+    ULong64_t GetDecodeNs() const { return decode_ns_; }
+    ULong64_t GetChecksumFailures() const { return checksum_failures_; }
+    ULong64_t GetRecordsAccepted() const { return records_accepted_; }
+    ULong64_t GetRecordsRejected() const { return records_rejected_; }
+    ULong64_t GetRecordsCarried() const { return records_carried_; }
+
+    /// Failed records by the field that failed, as "<class>.<field>"
+    const std::map<std::string, ULong64_t>& GetFieldFailures() const { return field_failures_; }
+
+    void Clear(Option_t* option = "") override;
+
+private:
+    std::string stage_name_;
+    ULong64_t events_ = 0;
+    ULong64_t bytes_consumed_ = 0;
+    ULong64_t records_decoded_ = 0;
+    ULong64_t decode_failures_ = 0;
+    ULong64_t lock_wait_ns_ = 0;
+    ULong64_t decode_ns_ = 0;
+    ULong64_t checksum_failures_ = 0;
+    ULong64_t records_accepted_ = 0;
+    ULong64_t records_rejected_ = 0;
+    ULong64_t records_carried_ = 0;
+    std::map<std::string, ULong64_t> field_failures_;
+
+    ClassDefOverride(StageMetricsSummary, 4);
+};
+
+#endif // ANALYSIS_PIPELINE_UNPACKER_CORE_DATA_PRODUCTS_STAGE_METRICS_SUMMARY_H
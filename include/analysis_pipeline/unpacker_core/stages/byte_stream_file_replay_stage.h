@@ -0,0 +1,69 @@
+#ifndef ANALYSIS_PIPELINE_UNPACKER_CORE_STAGES_BYTE_STREAM_FILE_REPLAY_STAGE_H
+#define ANALYSIS_PIPELINE_UNPACKER_CORE_STAGES_BYTE_STREAM_FILE_REPLAY_STAGE_H
+
+#include "analysis_pipeline/core/stages/base_stage.h"
+#include "analysis_pipeline/unpacker_core/utils/mapped_file.h"
+#include "analysis_pipeline/unpacker_core/utils/packet_framing.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Offline replay source: memory-maps raw bank files and publishes one MappedByteStream
+/// view per event, so processor stages decode straight from the page cache with no read()
+/// copies. Parameters:
+///   "files":               paths replayed in order (or "file" for a single path)
+///   "output_product_name": product to publish, default "bytestream_bank_DATA"
+///   "bank_size_bytes":     bytes per event; 0 (default) publishes each file as one bank
+///   "packet_framing":      cut banks at the last complete record (see PacketFraming)
+///   "prefetch_banks":      banks to read ahead of the current one, default 1
+///   "release_consumed":    drop pages of banks two events back from the page cache
+///   "reset_last_index_key": last-index product reset to 0 for every new bank, if given
+/// Once every file is replayed the output product is removed.
+class ByteStreamFileReplayStage : public BaseStage {
+public:
+    ByteStreamFileReplayStage();
+    ~ByteStreamFileReplayStage() override = default;
+
+    void OnInit() override;
+    void Process() override;
+
+    std::string Name() const override { return "ByteStreamFileReplayStage"; }
+
+    bool IsFinished() const { return finished_; }
+
+private:
+    // Maps the next file with data; false when none are left
+    bool openNextFile();
+
+    // Size of the bank starting at position_ in the current file
+    size_t nextBankSize();
+
+    void publishBank(size_t size);
+    void resetLastReadIndex();
+
+    std::vector<std::string> files_;                 //!
+    std::string output_product_name_;                //!
+    std::string reset_last_index_key_;               //!
+    size_t bank_size_ = 0;                           //!
+    size_t prefetch_banks_ = 1;                      //!
+    bool release_consumed_ = false;                  //!
+
+    PacketFraming packet_framing_;                   //!
+    bool has_packet_framing_ = false;                //!
+
+    size_t next_file_ = 0;                           //!
+    std::shared_ptr<MappedFile> file_;               //!
+    size_t position_ = 0;                            //!
+    size_t released_up_to_ = 0;                      //!
+    size_t previous_bank_start_ = 0;                 //!
+    bool finished_ = false;                          //!
+
+    std::vector<uint64_t> scan_offsets_;             //! PacketScanner scratch
+    std::vector<uint32_t> scan_lengths_;             //!
+
+    ClassDefOverride(ByteStreamFileReplayStage, 1);
+};
+
+#endif // ANALYSIS_PIPELINE_UNPACKER_CORE_STAGES_BYTE_STREAM_FILE_REPLAY_STAGE_H
@@ -3,11 +3,32 @@
 
 #include "analysis_pipeline/core/stages/base_stage.h"
 #include "analysis_pipeline/unpacker_core/data_products/ByteStream.h"
+#include "analysis_pipeline/unpacker_core/data_products/ColumnarRecordBatch.h"
+#include "analysis_pipeline/unpacker_core/data_products/PacketIndex.h"
+#include "analysis_pipeline/unpacker_core/data_products/RecordViewCollection.h"
 #include "analysis_pipeline/core/data/pipeline_data_product_read_lock.h"
 #include "analysis_pipeline/unpacker_core/utils/field_mapping_parser.h" 
+#include "analysis_pipeline/unpacker_core/utils/ingest_ring.h"
+#include "analysis_pipeline/unpacker_core/utils/object_pool.h"
+#include "analysis_pipeline/unpacker_core/utils/packet_checksum.h"
+#include "analysis_pipeline/unpacker_core/utils/record_carry.h"
+#include "analysis_pipeline/unpacker_core/utils/record_dispatch.h"
+#include "analysis_pipeline/unpacker_core/utils/record_predicate.h"
+#include "analysis_pipeline/unpacker_core/utils/stage_metrics.h"
+#include "analysis_pipeline/unpacker_core/utils/static_layout.h"
+#include "analysis_pipeline/unpacker_core/utils/work_stealing_pool.h"
 
+#include <TClonesArray.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+class ReflectionBasedParser;
 
 class ByteStreamProcessorStage : public BaseStage {
 public:
@@ -20,27 +41,463 @@ public:
     std::string Name() const override { return "ByteStreamProcessorStage"; }
 
 protected:
-    int getLastReadIndex() const;
-    void setLastReadIndex(int index);
+    /// Read cursor into the ByteStream. Once the stage calls endEvent(), the cursor is cached
+    /// in the stage: it is read from the last-index product once per event and written back
+    /// at endEvent() or syncLastReadIndex(). Until then every call goes to the product.
+    /// The product is a TParameter<Long64_t>. With "wide_last_index": false it starts as a
+    /// TParameter<int> and is replaced by a TParameter<Long64_t> once an index exceeds it.
+    int64_t getLastReadIndex() const;
+    void setLastReadIndex(int64_t index);
+
+    /// Writes a pending cursor to the last-index product now, for stages that hand the
+    /// stream to another stage within the same event
+    void syncLastReadIndex();
 
     /// Returns a lock object holding a read lock on the ByteStream product.
     /// If product does not exist or lock fails, returns invalid PipelineDataProductLock.
     PipelineDataProductReadLock getInputByteStreamLock() const;
 
+    /// Bytes of an input published by ByteStreamFileReplayStage, read in place from the
+    /// mapped file. Returns false if the locked product is not a MappedByteStream, so stages
+    /// can fall back to their ByteStream path.
+    bool getMappedInputBytes(const PipelineDataProductReadLock& lock,
+                             const uint8_t*& data,
+                             size_t& data_size) const;
+
+    /// Returns the bytes of a locked input product through data and data_size
+    using InputBytesFn = std::function<bool(const TObject& product, const uint8_t*& data, size_t& data_size)>;
+
+    /// Pipelined alternative to getInputByteStreamLock(): the read lock is held only while
+    /// the current bank is captured into the stage's IngestRing, so the producer can write
+    /// the next bank while this one is decoded. Mapped banks are shared without a copy;
+    /// other products are copied from the buffer bytes_of reports. The slot is reserved
+    /// before the lock is taken, so a back-pressure wait does not stall the producer.
+    /// Returns an empty Bank if the product is missing or unreadable, or if back-pressure
+    /// dropped the bank.
+    /// Configured by "pipelined_ingestion": {"slots": N, "back_pressure": "block" | "drop"
+    /// | "grow", "block_timeout_ms": T}; without it, two slots that grow on demand.
+    IngestRing::Bank acquireInputBank(const InputBytesFn& bytes_of = nullptr);
+
+    std::unique_ptr<TObject> parseObjectFromBytes(
+        TObject* obj,
+        const uint8_t* data,
+        size_t data_size,
+        const nlohmann::json& field_mapping_json,
+        size_t start_offset);
+
+    /// Same as above with a plan from getPlan(). Stages decoding one object per record use
+    /// this form so the mapping is not looked up again for every record.
     std::unique_ptr<TObject> parseObjectFromBytes(
         TObject* obj,
         const uint8_t* data,
         size_t data_size,
+        const std::shared_ptr<const CompiledParsePlan>& plan,
+        size_t start_offset);
+
+    /// Compiled plan of a field mapping for `cls`, cached by the mapping's content. Fetch it
+    /// once per configuration and keep it. Returns nullptr if the mapping does not compile.
+    std::shared_ptr<const CompiledParsePlan> getPlan(TClass* cls, const nlohmann::json& field_mapping_json);
+
+    /// Decodes `count` same-layout records spaced `stride` bytes apart, starting at start_offset,
+    /// into a new TClonesArray of `class_name`. Decoding stops at the first malformed record, so
+    /// the array holds the records that were decoded successfully. Returns nullptr on bad arguments.
+    /// With "parallel_decode": {"threads": N, "min_chunk_records": M} in the stage parameters,
+    /// batches of at least 2*M records are split across N threads with identical results.
+    std::unique_ptr<TClonesArray> parseRecordsFromBytes(
+        const std::string& class_name,
+        const uint8_t* data,
+        size_t data_size,
+        size_t stride,
+        size_t count,
+        const nlohmann::json& field_mapping_json,
+        size_t start_offset);
+
+    /// Same as above, refilling an existing array so its objects are reused across events.
+    /// A stride of 0 reads variable-length records (mappings with vector fields) back to back.
+    /// Returns the number of entries in `out`; `consumed` receives the number of records read
+    /// from `data`, which is where the caller moves its read cursor.
+    /// With a "checksum" stage parameter (see PacketChecksum, plus "on_failure": "drop" or
+    /// "keep"), fixed-stride and indexed records are verified in the decode pass itself.
+    /// Dropped records are consumed but left out of `out`; each batch with failures logs one
+    /// warning and adds to getChecksumFailureCount().
+    /// Records failing the "selection" cut are skipped the same way, before any decoding.
+    size_t parseRecordsFromBytes(
+        TClonesArray& out,
+        const uint8_t* data,
+        size_t data_size,
+        size_t stride,
+        size_t count,
+        const nlohmann::json& field_mapping_json,
+        size_t start_offset,
+        size_t* consumed = nullptr);
+
+    /// Uses the parser's compiled plan, with GetTotalParsedSize() as the record stride, or
+    /// back to back if the class has variable-length fields.
+    size_t parseRecordsFromBytes(
+        TClonesArray& out,
+        const uint8_t* data,
+        size_t data_size,
+        size_t count,
+        const ReflectionBasedParser& parser,
+        size_t start_offset,
+        size_t* consumed = nullptr);
+
+    /// Lazy alternative to parseRecordsFromBytes: wraps the records as RecordViews over `data`
+    /// without decoding anything. Fields are decoded on access and objects only on request.
+    /// With the owner of `data` (IngestRing::Bank::owner, MappedByteStream::GetFile()) the
+    /// views point into `data` and keep it alive; without one the records' bytes are copied,
+    /// since a locked ByteStream may be refilled once the lock is released.
+    std::unique_ptr<RecordViewCollection> makeRecordViews(
+        const std::string& class_name,
+        const uint8_t* data,
+        size_t data_size,
+        size_t stride,
+        size_t count,
+        const nlohmann::json& field_mapping_json,
+        size_t start_offset,
+        std::shared_ptr<const void> owner = nullptr);
+
+    /// Uses the parser's compiled plan, with GetTotalParsedSize() as the record stride.
+    /// Classes with variable-length fields are not supported.
+    std::unique_ptr<RecordViewCollection> makeRecordViews(
+        const ReflectionBasedParser& parser,
+        const uint8_t* data,
+        size_t data_size,
+        size_t count,
+        size_t start_offset,
+        std::shared_ptr<const void> owner = nullptr);
+
+    /// Checks a compile-time layout (see StaticLayout) against its class's reflection and,
+    /// if given, the JSON mapping it stands in for. Call from OnInit() for every layout the
+    /// stage decodes with; logs and returns false on a mismatch.
+    template<typename Layout>
+    bool verifyStaticLayout(const nlohmann::json* field_mapping_json = nullptr) const {
+        std::string error;
+        TClass* cls = TClass::GetClass(typeid(typename Layout::Class));
+        if (!Layout::Verify(cls, error, field_mapping_json)) {
+            spdlog::error("[{}] Static layout for class '{}' does not match: {}",
+                          Name(), cls ? cls->GetName() : typeid(typename Layout::Class).name(), error);
+            return false;
+        }
+        return true;
+    }
+
+    /// Like parseRecordsFromBytes, with the record layout fixed at compile time: every record
+    /// decodes through inlined loads and swaps instead of the runtime plan. `out` must hold
+    /// Layout::Class. The range is checked once; decoding itself cannot fail.
+    template<typename Layout>
+    size_t parseRecordsWithLayout(
+        TClonesArray& out,
+        const uint8_t* data,
+        size_t data_size,
+        size_t stride,
+        size_t count,
+        size_t start_offset)
+    {
+        using Record = typename Layout::Class;
+        out.Clear();
+
+        if (out.GetClass() != TClass::GetClass(typeid(Record))) {
+            spdlog::error("[{}] Output TClonesArray does not hold the static layout's class", Name());
+            return 0;
+        }
+        if (count == 0 || !validateRecordRange(data, data_size, stride, count, start_offset)) {
+            return 0;
+        }
+        const size_t last_start = start_offset + (count - 1) * stride;
+        if (Layout::kExtent > data_size - last_start) {
+            spdlog::error("[{}] Record {} of {} (offset {}, {} bytes) exceeds data size {}",
+                          Name(), count - 1, count, last_start, Layout::kExtent, data_size);
+            return 0;
+        }
+
+        StageMetrics::ScopedTimer timer(metrics_, StageMetrics::kDecodeNs);
+        const uint8_t* first = data + start_offset;
+        if (!decode_pool_ || count < 2 * parallel_min_chunk_) {
+            for (size_t i = 0; i < count; ++i) {
+                auto* obj = static_cast<Record*>(out.ConstructedAt(static_cast<Int_t>(i), "C"));
+                Layout::Decode(first + i * stride, *obj);
+            }
+        } else {
+            decode_targets_.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                decode_targets_[i] = out.ConstructedAt(static_cast<Int_t>(i), "C");
+            }
+            decode_pool_->ParallelFor(count, parallel_min_chunk_, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    Layout::Decode(first + i * stride, *static_cast<Record*>(decode_targets_[i]));
+                }
+            });
+        }
+
+        metrics_.Add(StageMetrics::kRecordsDecoded, count);
+        metrics_.Add(StageMetrics::kBytesConsumed, count * stride);
+        return count;
+    }
+
+    /// Columnar alternative to parseRecordsFromBytes: decodes `count` records spaced `stride`
+    /// bytes apart into one contiguous column per mapped field instead of one object each.
+    /// Returns nullptr if the class, the mapping or the record range is invalid, or if the
+    /// mapping has fields without a columnar layout (vectors, custom type handlers).
+    std::unique_ptr<ColumnarRecordBatch> parseColumnsFromBytes(
+        const std::string& class_name,
+        const uint8_t* data,
+        size_t data_size,
+        size_t stride,
+        size_t count,
+        const nlohmann::json& field_mapping_json,
+        size_t start_offset);
+
+    /// Same as above, refilling an existing batch so its storage is reused across events.
+    /// Returns the number of records decoded: `count`, or 0 on error.
+    size_t parseColumnsFromBytes(
+        ColumnarRecordBatch& out,
+        TClass* cls,
+        const uint8_t* data,
+        size_t data_size,
+        size_t stride,
+        size_t count,
+        const nlohmann::json& field_mapping_json,
+        size_t start_offset);
+
+    /// Frames data from start_offset with the "packet_framing" stage parameter (see
+    /// PacketFraming). Returns false if no framing is configured.
+    bool buildPacketIndex(PacketIndex& index,
+                          const uint8_t* data,
+                          size_t data_size,
+                          size_t start_offset) const;
+
+    /// Publishes an index under "packet_index_product_name" (default: the input ByteStream
+    /// name + "_index") so later stages can share it instead of re-scanning the bank
+    void publishPacketIndex(std::unique_ptr<PacketIndex> index);
+
+    /// Decodes index records [first, first + count) of `data`, the buffer the index was built
+    /// over, into `out`. Uses the parallel decoder like parseRecordsFromBytes and stops at the
+    /// first malformed record. Returns the number of entries in `out`; `consumed` receives the
+    /// number of index records read, which also counts records dropped by the checksum or
+    /// the selection.
+    size_t parseIndexedRecords(
+        TClonesArray& out,
+        const PacketIndex& index,
+        size_t first,
+        size_t count,
+        const uint8_t* data,
+        size_t data_size,
+        const nlohmann::json& field_mapping_json,
+        size_t* consumed = nullptr);
+
+    /// Incremental decoding of a stream whose banks are cut at arbitrary byte positions.
+    /// Records are framed with "packet_framing" from start_offset and decoded in place; a
+    /// trailing record that continues past the bank end is copied to a stage-owned carry
+    /// buffer (RecordCarry, at most "max_carried_record_bytes", default 1 MiB) instead of
+    /// being dropped. The next call completes it from the head of its bank, decodes it first
+    /// from the carry buffer, and goes on in place. Checksums and the selection apply as in
+    /// parseRecordsFromBytes; a carried record that fails to decode is dropped. Returns the
+    /// number of entries in `out`, a stitched record included; end_offset receives the first
+    /// bank byte not consumed, which is data_size once the tail is carried, and is where the
+    /// caller moves its read cursor.
+    size_t parseStreamRecords(
+        TClonesArray& out,
+        const uint8_t* data,
+        size_t data_size,
         const nlohmann::json& field_mapping_json,
+        size_t start_offset,
+        size_t* end_offset = nullptr);
+
+    /// Bytes of a partial record waiting for the next bank; 0 when none is carried
+    size_t getCarriedBytes() const { return record_carry_.Size(); }
+
+    /// Drops a carried partial record, for stages that restart the stream (a new run or
+    /// file) so its head is not stitched onto unrelated bytes
+    void resetRecordCarry() { record_carry_.Clear(); }
+
+    /// Decodes a bank that interleaves several record kinds in one pass, with the
+    /// "record_dispatch" table from the stage parameters (see RecordDispatchTable). Each kind
+    /// is published as a TClonesArray under its type's product name. Stops at a truncated
+    /// record, a record that fails to decode, or an unknown tag unless those are skipped.
+    /// Returns the number of records decoded; end_offset receives the first byte not consumed.
+    size_t dispatchRecords(const uint8_t* data,
+                           size_t data_size,
+                           size_t start_offset,
+                           size_t* end_offset = nullptr);
+
+    /// Selection cut from the "selection" stage parameter, e.g. "adc > 50 && channel != 17"
+    /// (see RecordPredicate), compiled against `plan` on first use. Returns nullptr if there is
+    /// no selection or it does not compile for the plan's mapping.
+    const RecordPredicate* getSelection(const std::shared_ptr<const CompiledParsePlan>& plan);
+
+    /// True if the record at start_offset passes the selection, reading only the fields the
+    /// cut references. Stages decoding one object at a time call this before
+    /// parseObjectFromBytes to skip the allocation and decode of rejected records; the batch
+    /// decoders apply the selection themselves. Counts accepted and rejected records in the
+    /// stage metrics.
+    bool passesSelection(const std::shared_ptr<const CompiledParsePlan>& plan,
+                         const uint8_t* data,
+                         size_t data_size,
+                         size_t start_offset);
+
+    /// Per-stage pool of recycled objects of `cls`, created on first use.
+    /// Returns nullptr if the class cannot be pooled.
+    ObjectPool* getObjectPool(TClass* cls);
+
+    /// Like parseObjectFromBytes, but the object is taken from this stage's pool for `cls`
+    /// and goes back to it when the PooledObject, or the PooledObjectCollection product
+    /// holding it, is released. Returns an empty pointer on failure.
+    PooledObject parsePooledObjectFromBytes(
+        TClass* cls,
+        const uint8_t* data,
+        size_t data_size,
+        const nlohmann::json& field_mapping_json,
+        size_t start_offset);
+
+    /// Same as above for the plan's class, with a plan from getPlan()
+    PooledObject parsePooledObjectFromBytes(
+        const std::shared_ptr<const CompiledParsePlan>& plan,
+        const uint8_t* data,
+        size_t data_size,
         size_t start_offset);
 
+    /// Marks the end of an event for derived stages; call once at the end of Process().
+    /// Writes back the read cursor, and publishes the stage metrics every
+    /// "publish_every_events" events if they are enabled.
+    void endEvent();
+
+    /// Records that failed their checksum since OnInit(). Counted whether or not the
+    /// library is built with stage metrics; each batch with failures is also logged once.
+    uint64_t getChecksumFailureCount() const { return checksum_failure_count_; }
+
+    /// Hot-path counters, filled by the decode helpers and getInputByteStreamLock().
+    /// Derived stages may add their own counts, e.g. bytes they consume directly.
+    StageMetrics& metrics() const { return metrics_; }
+
     std::string last_index_product_name_;
     std::string input_byte_stream_product_name_;
 
 private:
-    void createLastReadIndexProduct(int index);
+    // An index a TParameter<int> product cannot hold promotes it to TParameter<Long64_t>
+    // rather than being truncated
+    bool createLastReadIndexProduct(int64_t index, bool wide);
+    int64_t readLastReadIndexProduct() const;
+    bool writeLastReadIndexProduct(int64_t index);
+    void publishMetrics();
+
+    bool decodeObject(TObject* obj,
+                      const uint8_t* data,
+                      size_t data_size,
+                      const CompiledParsePlan& plan,
+                      size_t start_offset);
+
+    void recordDecodeFailure(const CompiledParsePlan& plan, const std::string* field);
+
+    // Decodes one record: trusted skips the fixed-layout checks a batch check already made,
+    // while "debug_bounds_checks" checks every field so failures name it
+    bool executePlan(const CompiledParsePlan& plan,
+                     bool trusted,
+                     const uint8_t* data,
+                     size_t data_size,
+                     size_t start_offset,
+                     TObject* obj,
+                     size_t* record_size = nullptr) const {
+        if (debug_bounds_checks_) {
+            return plan.ExecuteChecked(data, data_size, start_offset, obj, record_size);
+        }
+        return trusted ? plan.ExecuteTrusted(data, data_size, start_offset, obj, record_size)
+                       : plan.Execute(data, data_size, start_offset, obj, record_size);
+    }
+    void reportChecksumFailures(size_t failures, size_t checked);
+
+    bool validateRecordRange(const uint8_t* data,
+                             size_t data_size,
+                             size_t stride,
+                             size_t count,
+                             size_t start_offset) const;
+
+    std::unique_ptr<RecordViewCollection> makeRecordViewsWithPlan(
+        const std::shared_ptr<const CompiledParsePlan>& plan,
+        const uint8_t* data,
+        size_t data_size,
+        size_t stride,
+        size_t count,
+        size_t start_offset,
+        std::shared_ptr<const void> owner);
+
+    size_t parseRecordsWithPlan(TClonesArray& out,
+                                const std::shared_ptr<const CompiledParsePlan>& plan,
+                                const uint8_t* data,
+                                size_t data_size,
+                                size_t stride,
+                                size_t count,
+                                size_t start_offset,
+                                size_t* consumed);
+
+    // Serial or parallel decode of count records at offset_of(i), length_of(i) bytes long,
+    // appended to out; stops at the first failure. Returns the entries appended to out and
+    // sets consumed to the records read, including those failing the selection or a
+    // checksum set to drop, which are left out of out.
+    // trusted: the caller checked every record with plan.CheckRange() and out holds the plan's class.
+    template<typename OffsetFn, typename LengthFn>
+    size_t decodeRecords(TClonesArray& out,
+                         const CompiledParsePlan& plan,
+                         const uint8_t* data,
+                         size_t data_size,
+                         size_t count,
+                         bool trusted,
+                         const RecordPredicate* selection,
+                         OffsetFn offset_of,
+                         LengthFn length_of,
+                         size_t& consumed);
+
+    size_t parseConsecutiveRecords(TClonesArray& out,
+                                   const CompiledParsePlan& plan,
+                                   const uint8_t* data,
+                                   size_t data_size,
+                                   size_t count,
+                                   size_t start_offset);
 
     FieldMappingParser field_mapping_parser_;  // internal state
+    std::unordered_map<TClass*, std::shared_ptr<ObjectPool>> object_pools_;  //!
+
+    std::unique_ptr<WorkStealingPool> decode_pool_;  //! only set when parallel decoding is enabled
+    size_t parallel_min_chunk_ = 256;                //!
+    std::vector<TObject*> decode_targets_;           //!
+    std::vector<uint8_t> record_skipped_;            //! per record of a parallel batch
+    std::vector<size_t> kept_records_;               //! records of a parallel batch that are decoded
+    bool debug_bounds_checks_ = false;               //! every field checked on its own
+
+    std::string selection_expression_;               //! empty when there is no selection
+    // Selection compiled per plan; the weak pointer tells a reused plan address from the original
+    std::unordered_map<const CompiledParsePlan*,
+                       std::pair<std::weak_ptr<const CompiledParsePlan>,
+                                 std::shared_ptr<const RecordPredicate>>> selections_;  //!
+
+    PacketChecksum checksum_;                        //!
+    bool has_checksum_ = false;                      //!
+    bool drop_bad_checksums_ = true;                 //!
+    uint64_t checksum_failure_count_ = 0;            //! independent of the metrics build switch
+
+    std::shared_ptr<IngestRing> ingest_ring_;        //!
+
+    RecordDispatchTable dispatch_table_;             //!
+    bool has_dispatch_table_ = false;                //!
+
+    PacketFraming packet_framing_;                   //!
+    bool has_packet_framing_ = false;                //!
+    std::string packet_index_product_name_;          //!
+
+    RecordCarry record_carry_;                       //! partial record at the end of the last bank
+    std::vector<uint64_t> stream_offsets_;           //! framing scratch for parseStreamRecords
+    std::vector<uint32_t> stream_lengths_;           //!
+
+    mutable StageMetrics metrics_;                   //! thread-safe; also counts from const lock helpers
+    std::string metrics_product_name_;               //! empty when metrics are not published
+    size_t metrics_publish_every_ = 1;               //!
+    size_t events_since_publish_ = 0;                //!
+
+    bool cache_cursor_ = false;                      //! set by the first endEvent()
+    bool wide_index_product_ = true;                 //! TParameter<Long64_t> instead of TParameter<int>
+    mutable bool cursor_loaded_ = false;             //!
+    bool cursor_dirty_ = false;                      //!
+    mutable int64_t cursor_ = 0;                     //!
 
     ClassDefOverride(ByteStreamProcessorStage, 1);
 };
@@ -0,0 +1,69 @@
+#ifndef UNPACKER_CORE_UTILS_BIT_UNPACK_H
+#define UNPACKER_CORE_UTILS_BIT_UNPACK_H
+
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Extraction of sub-byte fields and densely packed sample arrays.
+//
+// A scalar bit field is `bit_width` bits starting `bit_offset` bits above the least significant
+// bit of a 1, 2, 4 or 8 byte word. A packed array is a bit stream of back-to-back samples:
+// LSB-first with little-endian byte order, or MSB-first with big-endian byte order.
+class BitUnpack {
+public:
+    // Precomputed shift/mask for one scalar bit field, built once when a mapping is compiled
+    struct FieldSpec {
+        uint8_t word_size = 0;
+        bool swap = false;
+        uint8_t shift = 0;
+        uint8_t sign_shift = 0;  // 64 - bit_width when sign-extending, else 0
+        uint64_t mask = 0;
+    };
+
+    static FieldSpec MakeFieldSpec(size_t word_size, bool swap, size_t bit_offset, size_t bit_width, bool sign_extend);
+
+    // Value of the field with sign extension applied; src must hold word_size bytes
+    static inline uint64_t Extract(const FieldSpec& spec, const uint8_t* src) {
+        uint64_t word = LoadWord(src, spec.word_size, spec.swap);
+        uint64_t value = (word >> spec.shift) & spec.mask;
+        if (spec.sign_shift) {
+            value = static_cast<uint64_t>(static_cast<int64_t>(value << spec.sign_shift) >> spec.sign_shift);
+        }
+        return value;
+    }
+
+    // Store the low dst_width bytes of value (1, 2, 4 or 8) at an unaligned address
+    static void StoreInteger(void* dst, size_t dst_width, uint64_t value);
+
+    // Unpack `count` samples of bit_width bits into dst elements of dst_width bytes. Reads
+    // exactly PackedBytes(bit_offset, bit_width, count) bytes from src. Samples of up to 16
+    // bits into 16-bit elements, e.g. 12- or 14-bit ADC values at any bit offset, go through
+    // an AVX2 kernel, and byte-aligned 12-bit samples also through SSSE3; other layouts, and
+    // CPUs without those, unpack one sample at a time.
+    static void UnpackArray(void* dst,
+                            size_t dst_width,
+                            const uint8_t* src,
+                            size_t bit_offset,
+                            size_t bit_width,
+                            size_t count,
+                            bool msb_first,
+                            bool sign_extend);
+
+    static size_t PackedBytes(size_t bit_offset, size_t bit_width, size_t count) {
+        return (bit_offset + bit_width * count + 7) / 8;
+    }
+
+private:
+    static inline uint64_t LoadWord(const uint8_t* src, size_t word_size, bool swap) {
+        switch (word_size) {
+            case 1: return *src;
+            case 2: return ByteSwap::Load<uint16_t>(src, swap);
+            case 4: return ByteSwap::Load<uint32_t>(src, swap);
+            default: return ByteSwap::Load<uint64_t>(src, swap);
+        }
+    }
+};
+
+#endif // UNPACKER_CORE_UTILS_BIT_UNPACK_H
@@ -0,0 +1,61 @@
+#ifndef UNPACKER_CORE_UTILS_BYTE_SWAP_H
+#define UNPACKER_CORE_UTILS_BYTE_SWAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Width-specialized byte order reversal. Scalars compile to a single bswap/rev instruction;
+// array kernels pick an AVX2, SSSE3 or scalar implementation once at startup.
+class ByteSwap {
+public:
+    static inline uint16_t Swap16(uint16_t v) { return __builtin_bswap16(v); }
+    static inline uint32_t Swap32(uint32_t v) { return __builtin_bswap32(v); }
+    static inline uint64_t Swap64(uint64_t v) { return __builtin_bswap64(v); }
+
+    // Byte-reverse any 1, 2, 4 or 8 byte trivially copyable value (integers, float, double)
+    template<typename T>
+    static inline T SwapValue(T value) {
+        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+                      "SwapValue supports 1, 2, 4 and 8 byte types");
+        if constexpr (sizeof(T) == 2) {
+            uint16_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits = Swap16(bits);
+            std::memcpy(&value, &bits, sizeof(bits));
+        } else if constexpr (sizeof(T) == 4) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits = Swap32(bits);
+            std::memcpy(&value, &bits, sizeof(bits));
+        } else if constexpr (sizeof(T) == 8) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits = Swap64(bits);
+            std::memcpy(&value, &bits, sizeof(bits));
+        }
+        return value;
+    }
+
+    // Unaligned load of a value, byte-reversed when the source order differs from the host
+    template<typename T>
+    static inline T Load(const void* src, bool swap) {
+        T value;
+        std::memcpy(&value, src, sizeof(T));
+        return swap ? SwapValue(value) : value;
+    }
+
+    // Copy `count` elements from src to dst reversing each element's bytes.
+    // src and dst may be unaligned and may be the same buffer, but must not partially overlap.
+    static void SwapArray16(void* dst, const void* src, size_t count);
+    static void SwapArray32(void* dst, const void* src, size_t count);
+    static void SwapArray64(void* dst, const void* src, size_t count);
+
+    // Dispatches on element_size; sizes other than 2, 4 and 8 use a generic byte loop
+    static void SwapArray(void* dst, const void* src, size_t element_size, size_t count);
+
+    // "avx2", "ssse3" or "scalar"
+    static const char* ActiveKernelName();
+};
+
+#endif // UNPACKER_CORE_UTILS_BYTE_SWAP_H
@@ -0,0 +1,32 @@
+#ifndef UNPACKER_CORE_UTILS_COLUMN_DECODER_H
+#define UNPACKER_CORE_UTILS_COLUMN_DECODER_H
+
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Decodes one mapped field of a run of fixed-stride records into a contiguous column,
+// converting to host byte order. Scalar columns are gathered first and then byte-swapped in
+// place over the contiguous column with the SIMD swap kernels; array fields go through the
+// field's copy kernel once per record.
+class ColumnDecoder {
+public:
+    // Built-in scalars, array<T,N> and bit fields; not vectors, fields placed after them,
+    // or types with a custom TypeRegistry handler
+    static bool Supports(const CompiledParsePlan::FieldOp& field);
+
+    // Writes records [first, first + count) of the column starting at `column`, with
+    // field.count elements of field.element_size bytes per record. The caller checks that
+    // every record lies inside the buffer.
+    static void Decode(const CompiledParsePlan::FieldOp& field,
+                       const uint8_t* data,
+                       size_t data_size,
+                       size_t start_offset,
+                       size_t stride,
+                       size_t first,
+                       size_t count,
+                       uint8_t* column);
+};
+
+#endif // UNPACKER_CORE_UTILS_COLUMN_DECODER_H
@@ -0,0 +1,178 @@
+#ifndef UNPACKER_CORE_UTILS_COMPILED_PARSE_PLAN_H
+#define UNPACKER_CORE_UTILS_COMPILED_PARSE_PLAN_H
+
+#include "analysis_pipeline/unpacker_core/utils/bit_unpack.h"
+#include "analysis_pipeline/unpacker_core/utils/type_registry.h"
+
+#include <TObject.h>
+#include <TClass.h>
+#include <TDataMember.h>
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A JSON field mapping resolved once against a TClass. Executing the plan walks a flat
+// vector of copy operations; no JSON, string or ROOT reflection lookups happen per object.
+//
+// Besides "offset", "size" and "endianness", an integer field may set "bit_width" (with
+// optional "bit_offset" and "signed") to extract a sub-byte value from a `size`-byte word.
+// On an array<T,N> member the same keys describe N samples packed back to back, LSB-first
+// for little endian and MSB-first for big endian data.
+//
+// A vector<T> member is variable-length: "count_from" names an integer field holding its
+// element count, or "terminator" gives the element value that ends it (optionally capped by
+// "max_count"); "size" is not needed. A field with "after": "<field>" is placed "offset"
+// bytes past the end of that variable-length field, or of another field placed after one.
+class CompiledParsePlan {
+public:
+    static constexpr size_t kNoField = static_cast<size_t>(-1);
+
+    // Fields placed after variable-length data; bounds the per-record offset table
+    static constexpr size_t kMaxDynamicFields = 32;
+
+    // Arithmetic kind of a member's elements, so raw reads can refuse a mismatched type
+    enum class ValueKind : uint8_t { kSigned, kUnsigned, kFloat };
+
+    struct FieldOp {
+        size_t member_offset = 0;   // byte offset of the member inside the object
+        int64_t source_offset = 0;  // relative to start_offset; negative counts from the buffer end
+        size_t size = 0;            // bytes that must be available in the buffer
+        size_t element_size = 0;
+        size_t count = 0;           // number of elements copied by the kernel
+        ValueKind value_kind = ValueKind::kSigned;  // of the member's elements
+        size_t field_count = 1;     // mapped fields covered by this op (>1 once coalesced)
+        bool swap = false;          // source byte order differs from the host
+        TypeRegistry::CopyKernel kernel = nullptr;
+
+        // Sub-byte fields (bit_width > 0) are extracted from the source bits instead of copied
+        size_t bit_offset = 0;
+        size_t bit_width = 0;
+        bool sign_extend = false;
+        BitUnpack::FieldSpec bits;  // scalar fields only
+
+        // vector<T> members and fields placed after them ("dynamic" fields) are decoded after
+        // the fixed layout, at offsets computed per record
+        bool dynamic = false;
+        size_t slot = 0;                   // position among the dynamic ops
+        size_t anchor_slot = kNoField;     // if set, source_offset counts from the end of that dynamic op
+        TypeRegistry::VectorResize resize = nullptr;
+        size_t count_field = kNoField;     // member holding the element count (index in GetFields())
+        bool terminated = false;           // vector ends at the first element equal to terminator
+        uint64_t terminator = 0;           // raw element bits
+        size_t max_count = 0;              // 0 means unbounded
+
+        // Types registered through TypeRegistry::RegisterHandler keep their handler
+        TypeRegistry::HandlerFunc handler;
+        TDataMember* member = nullptr;
+        bool little_endian = true;
+
+        std::string name;  // diagnostics only
+    };
+
+    struct Stats {
+        size_t fields = 0;            // mapped fields
+        size_t ops = 0;               // operations executed per object
+        size_t coalesced_fields = 0;  // fields folded into bulk copies
+        size_t coalesced_runs = 0;    // bulk copies covering more than one field
+    };
+
+    // Returns nullptr (after logging) if the mapping does not resolve against the class
+    static std::shared_ptr<const CompiledParsePlan> Compile(const nlohmann::json& json_field_mapping, TClass* cls);
+
+    // record_size, if given, receives the bytes past start_offset that the record occupied,
+    // including any variable-length data
+    bool Execute(const uint8_t* buffer,
+                 size_t buffer_size,
+                 size_t start_offset,
+                 TObject* obj,
+                 size_t* record_size = nullptr) const;
+
+    // True if every record starting in [first_offset, last_offset] holds the fixed fields and
+    // the buffer holds the end-relative ones. Check a batch once, then decode its records
+    // with ExecuteTrusted().
+    bool CheckRange(size_t buffer_size, size_t first_offset, size_t last_offset) const;
+
+    // Execute() without the class and bounds checks of the fixed layout: obj must be of
+    // GetClass() and start_offset covered by a successful CheckRange(). Variable-length
+    // fields are still checked, since their extent depends on the data.
+    bool ExecuteTrusted(const uint8_t* buffer,
+                        size_t buffer_size,
+                        size_t start_offset,
+                        TObject* obj,
+                        size_t* record_size = nullptr) const;
+
+    // Execute() with every field bounds-checked on its own, so LastFailedField() names the
+    // first field of a malformed record that leaves the buffer. For debugging; callers
+    // choose it per decode, e.g. from a stage's "debug_bounds_checks" parameter.
+    bool ExecuteChecked(const uint8_t* buffer,
+                        size_t buffer_size,
+                        size_t start_offset,
+                        TObject* obj,
+                        size_t* record_size = nullptr) const;
+
+    // Name of the field that failed the calling thread's last unsuccessful Execute(), or
+    // nullptr if the record was rejected as a whole (wrong class). Meaningless after success.
+    static const std::string* LastFailedField();
+
+    TClass* GetClass() const { return cls_; }
+    const std::vector<FieldOp>& GetOps() const { return ops_; }
+
+    // One entry per mapped field, before coalescing; used to read single fields lazily
+    const std::vector<FieldOp>& GetFields() const { return fields_; }
+    size_t FindField(const std::string& name) const;
+    const Stats& GetStats() const { return stats_; }
+
+    // Decode a bit field or packed array; src points at the field's first source byte
+    static void DecodeBits(const FieldOp& op, void* dst, const uint8_t* src) {
+        if (op.count == 1) {
+            BitUnpack::StoreInteger(dst, op.element_size, BitUnpack::Extract(op.bits, src));
+        } else {
+            BitUnpack::UnpackArray(dst, op.element_size, src, op.bit_offset, op.bit_width, op.count,
+                                   !op.little_endian, op.sign_extend);
+        }
+    }
+
+    // Bytes past start_offset touched by record-relative fields
+    size_t GetRecordExtent() const { return record_extent_; }
+
+    // True if records contain vector fields, so their size is only known once decoded
+    bool HasVariableLength() const { return !dynamic_ops_.empty(); }
+
+private:
+    CompiledParsePlan() = default;
+
+    static bool CompileBitField(const nlohmann::json& field_info,
+                                const std::string& type_name,
+                                size_t element_size,
+                                size_t count,
+                                FieldOp& op);
+    static bool CompileVectorField(const nlohmann::json& field_info, const std::string& type_name, FieldOp& op);
+    bool ResolveDynamicFields(const std::vector<std::pair<std::string, std::string>>& links);
+    void Coalesce();
+    template<bool kCheckFields>
+    bool ExecuteOps(const uint8_t* buffer,
+                    size_t buffer_size,
+                    size_t start_offset,
+                    TObject* obj,
+                    size_t* record_size) const;
+    bool ExecuteDynamic(const uint8_t* buffer,
+                        size_t buffer_size,
+                        size_t start_offset,
+                        TObject* obj,
+                        size_t* record_size) const;
+    bool DecodeVector(const FieldOp& op, char* base, const uint8_t* buffer, size_t buffer_size,
+                      size_t abs_offset, size_t& end) const;
+
+    TClass* cls_ = nullptr;
+    std::vector<FieldOp> ops_;  // record-relative ops sorted by source offset, then end-relative ops
+    std::vector<FieldOp> dynamic_ops_;  // in dependency order, after ops_
+    std::vector<FieldOp> fields_;
+    size_t record_extent_ = 0;
+    Stats stats_;
+};
+
+#endif // UNPACKER_CORE_UTILS_COMPILED_PARSE_PLAN_H
@@ -1,33 +1,65 @@
 #ifndef FIELD_MAPPING_PARSER_H
 #define FIELD_MAPPING_PARSER_H
 
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+
 #include <TObject.h>
 #include <TClass.h>
 #include <TDataMember.h>
 #include <nlohmann/json.hpp>
 
 #include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 
 class FieldMappingParser {
 public:
     FieldMappingParser() = default;
     ~FieldMappingParser() = default;
 
-    // Parse buffer according to json mapping, fill fields of obj accordingly
+    // Parse buffer according to json mapping, fill fields of obj accordingly.
+    // Looks the plan up with GetPlan() on every call; per-record loops should fetch the
+    // plan once and use the overload below.
     bool ParseAndFill(const uint8_t* buffer,
                       size_t buffer_size,
                       size_t start_offset,
                       const nlohmann::json& json_field_mapping,
                       TObject* obj);
 
+    // Parse buffer with an already compiled plan
+    bool ParseAndFill(const uint8_t* buffer,
+                      size_t buffer_size,
+                      size_t start_offset,
+                      const CompiledParsePlan& plan,
+                      TObject* obj) const;
+
+    // Parse a record of obj's class that plan.CheckRange() has already covered, e.g. one of
+    // a batch checked once up front; skips the per-record class and bounds checks
+    bool ParseAndFillTrusted(const uint8_t* buffer,
+                             size_t buffer_size,
+                             size_t start_offset,
+                             const CompiledParsePlan& plan,
+                             TObject* obj) const;
+
+    // Compiled plan for a mapping/class pair, built on first request. Plans are keyed by the
+    // mapping's content, so a mapping built as a local or temporary finds its own plan even
+    // at an address an earlier mapping used. A mapping that fails to compile is cached as a
+    // null plan and not compiled again. The lookup serializes the mapping, so callers fetch
+    // a plan once per configuration and keep it; holding it also keeps it valid when the
+    // cache is cleared.
+    std::shared_ptr<const CompiledParsePlan> GetPlan(const nlohmann::json& json_field_mapping, TClass* cls);
+
+    void ClearPlanCache() { plan_cache_.clear(); }
+
 private:
-    bool ExtractAndAssignField(const uint8_t* buffer,
-                               size_t buffer_size,
-                               size_t start_offset,
-                               const std::string& member_name,
-                               const nlohmann::json& field_info,
-                               TObject* obj);
+    using PlanKey = std::pair<std::string, TClass*>;  // serialized mapping and class
+
+    // Mappings generated per event would otherwise grow the cache without bound
+    static constexpr size_t kMaxCachedPlans = 256;
+
+    std::map<PlanKey, std::shared_ptr<const CompiledParsePlan>> plan_cache_;
 };
 
 #endif // FIELD_MAPPING_PARSER_H
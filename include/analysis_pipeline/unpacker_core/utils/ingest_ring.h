@@ -0,0 +1,101 @@
+#ifndef UNPACKER_CORE_UTILS_INGEST_RING_H
+#define UNPACKER_CORE_UTILS_INGEST_RING_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Ring of reusable bank buffers that decouples decoding from the input product's lock. A
+// stage holds the read lock only while a bank is captured into a free slot, then decodes
+// from the slot while the producer refills the product. A slot stays leased while any Bank
+// referencing it is alive, so record views into an earlier bank remain valid; with N slots
+// up to N banks are in flight. When every slot is leased, the back-pressure policy decides:
+// wait for one to be released, drop the new bank, or grow the ring.
+class IngestRing : public std::enable_shared_from_this<IngestRing> {
+private:
+    struct Slot;
+
+public:
+    enum class Policy { kBlock, kDrop, kGrow };
+
+    // Bytes of one captured bank; `owner` keeps them alive
+    struct Bank {
+        std::shared_ptr<const void> owner;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        uint64_t sequence = 0;  // counts captured banks, dropped ones included
+
+        explicit operator bool() const { return owner != nullptr; }
+    };
+
+    // kBlock waits up to block_timeout for a slot and then drops the bank
+    static std::shared_ptr<IngestRing> Create(size_t slots,
+                                              Policy policy,
+                                              std::chrono::milliseconds block_timeout = std::chrono::milliseconds(100));
+
+    // "block", "drop" or "grow"; false for anything else
+    static bool ParsePolicy(const std::string& name, Policy& policy);
+
+    // A free slot taken before the input product is locked, so waiting for one under the
+    // back-pressure policy never stalls the producer. Goes back to the ring unused if it is
+    // destroyed without being filled.
+    class Reservation {
+    public:
+        explicit operator bool() const { return slot_ != nullptr; }
+
+    private:
+        friend class IngestRing;
+        std::shared_ptr<Slot> slot_;
+    };
+
+    // Takes a slot according to the policy. Returns an empty Reservation, and counts the
+    // bank as dropped, if none became free.
+    Reservation Reserve();
+
+    // Copies a bank into a reserved slot; the reservation is used up
+    Bank Fill(Reservation reservation, const uint8_t* data, size_t size);
+
+    // Reserve() and Fill() in one step. Returns an empty Bank if it was dropped.
+    Bank Copy(const uint8_t* data, size_t size);
+
+    // Wraps bytes that already have a stable owner (e.g. a mapped file) without copying or
+    // taking a slot
+    Bank Share(std::shared_ptr<const void> owner, const uint8_t* data, size_t size);
+
+    size_t GetSlotCount() const;
+    size_t GetLeasedCount() const;
+    uint64_t GetDroppedCount() const;
+
+private:
+    struct Slot {
+        std::vector<uint8_t> bytes;
+    };
+
+    // Returns the slot to the ring, or frees it once the ring itself is gone
+    struct Releaser {
+        std::weak_ptr<IngestRing> ring;
+        void operator()(Slot* slot) const;
+    };
+
+    IngestRing(size_t slots, Policy policy, std::chrono::milliseconds block_timeout);
+
+    Slot* FindFreeLocked();
+    void Release(Slot* slot);
+
+    Policy policy_;
+    std::chrono::milliseconds block_timeout_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    std::vector<std::unique_ptr<Slot>> slots_;  // owned here while idle, by the Bank while leased
+    size_t leased_ = 0;
+    uint64_t sequence_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+#endif // UNPACKER_CORE_UTILS_INGEST_RING_H
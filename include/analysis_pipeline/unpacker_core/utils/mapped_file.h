@@ -0,0 +1,43 @@
+#ifndef UNPACKER_CORE_UTILS_MAPPED_FILE_H
+#define UNPACKER_CORE_UTILS_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+// Read-only memory mapping of a whole file. Pages are loaded from the page cache on first
+// access, so decoding straight from Data() needs no read() into a heap buffer.
+class MappedFile {
+public:
+    // Returns nullptr (after logging) if the file cannot be opened or mapped. With
+    // `sequential`, the kernel is told to read ahead aggressively and drop pages behind.
+    static std::shared_ptr<MappedFile> Open(const std::string& path, bool sequential = true);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    const std::string& Path() const { return path_; }
+
+    // Start reading [offset, offset + length) into the page cache in the background
+    void Prefetch(size_t offset, size_t length) const;
+
+    // Let the kernel reclaim [offset, offset + length) early; the mapping stays valid
+    void Release(size_t offset, size_t length) const;
+
+private:
+    MappedFile(std::string path, const uint8_t* data, size_t size)
+        : path_(std::move(path)), data_(data), size_(size) {}
+
+    void Advise(size_t offset, size_t length, int advice) const;
+
+    std::string path_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif // UNPACKER_CORE_UTILS_MAPPED_FILE_H
@@ -0,0 +1,67 @@
+#ifndef UNPACKER_CORE_UTILS_MAPPING_CACHE_H
+#define UNPACKER_CORE_UTILS_MAPPING_CACHE_H
+
+#include <TClass.h>
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class CompiledParsePlan;
+
+// Process-wide cache of the field mappings ReflectionBasedParser builds from ROOT
+// reflection, and of their compiled plans, shared by every stage. Entries are keyed by class
+// name, class version, class checksum, default endianness and field overrides, so a changed
+// class misses, is reflected again and replaces the mapping of its old version.
+//
+// With a cache file set, mappings persist across jobs as CBOR: the file is read once and
+// rewritten whenever a new class is reflected. The file comes from the UNPACKER_MAPPING_CACHE
+// environment variable or a stage's "mapping_cache_file" parameter. Plans hold TClass
+// pointers and are always recompiled from the cached mapping in a new process.
+class MappingCache {
+public:
+    struct Entry {
+        nlohmann::json mapping;
+        size_t total_parsed_size = 0;
+        std::shared_ptr<const CompiledParsePlan> plan;  // null until compiled in this process
+    };
+
+    static MappingCache& Instance();
+
+    std::shared_ptr<const Entry> Find(TClass* cls,
+                                      const std::string& default_endianness,
+                                      const nlohmann::json& field_overrides) const;
+
+    void Insert(TClass* cls,
+                const std::string& default_endianness,
+                const nlohmann::json& field_overrides,
+                std::shared_ptr<const Entry> entry);
+
+    // Loads the file if it exists and keeps it up to date from now on. Later calls with the
+    // same path do nothing; a different path switches files. Returns false if an existing
+    // file could not be read.
+    bool SetFile(const std::string& path);
+
+    size_t Size() const;
+    void Clear();
+
+private:
+    MappingCache() = default;
+    MappingCache(const MappingCache&) = delete;
+    MappingCache& operator=(const MappingCache&) = delete;
+
+    static std::string MakeKey(TClass* cls, const std::string& default_endianness, const nlohmann::json& field_overrides);
+    static std::string IdentityOf(const std::string& key);  // key without class version and checksum
+
+    bool LoadLocked(const std::string& path);
+    void SaveLocked() const;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const Entry>> entries_;
+    std::string file_;
+};
+
+#endif // UNPACKER_CORE_UTILS_MAPPING_CACHE_H
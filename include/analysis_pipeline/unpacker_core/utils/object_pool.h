@@ -0,0 +1,63 @@
+#ifndef UNPACKER_CORE_UTILS_OBJECT_POOL_H
+#define UNPACKER_CORE_UTILS_OBJECT_POOL_H
+
+#include <TObject.h>
+#include <TClass.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Recycles instances of a single TObject-derived class. Objects handed out by Acquire()
+// come back to the pool when their PooledObject is destroyed and are handed out again
+// instead of being freed and re-allocated.
+//
+// Like TClonesArray, a returned object is reset by running its destructor and default
+// constructor in place, so a recycled instance is indistinguishable from a new one: its
+// fields, TObject bits and unique ID are all back to their defaults.
+class ObjectPool : public std::enable_shared_from_this<ObjectPool> {
+public:
+    // Deleter for pooled objects; falls back to delete once the pool itself is gone
+    struct Recycler {
+        std::weak_ptr<ObjectPool> pool;
+        void operator()(TObject* obj) const;
+    };
+
+    using Pointer = std::unique_ptr<TObject, Recycler>;
+
+    static std::shared_ptr<ObjectPool> Create(TClass* cls, size_t max_idle = 4096);
+    ~ObjectPool();
+
+    // Recycled instance if one is idle, otherwise a newly constructed one.
+    // Returns an empty pointer if the class cannot be instantiated.
+    Pointer Acquire();
+
+    // Pre-construct objects so the first events do not pay for allocation
+    void Reserve(size_t count);
+
+    TClass* GetClass() const { return cls_; }
+    size_t GetIdleCount() const;
+    size_t GetCreatedCount() const;
+    size_t GetReusedCount() const;
+
+private:
+    ObjectPool(TClass* cls, size_t tobject_offset, size_t max_idle);
+
+    void Release(TObject* obj);
+    TObject* Construct() const;
+    bool Reset(TObject* obj) const;
+
+    TClass* cls_;
+    size_t tobject_offset_;  // of the TObject base within an instance of cls_
+    size_t max_idle_;
+
+    mutable std::mutex mutex_;
+    std::vector<TObject*> idle_;
+    size_t created_ = 0;
+    size_t reused_ = 0;
+};
+
+using PooledObject = ObjectPool::Pointer;
+
+#endif // UNPACKER_CORE_UTILS_OBJECT_POOL_H
@@ -0,0 +1,56 @@
+#ifndef UNPACKER_CORE_UTILS_PACKET_CHECKSUM_H
+#define UNPACKER_CORE_UTILS_PACKET_CHECKSUM_H
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Integrity check stored in each record by the front-end. For example
+//   {"algorithm": "crc32c", "offset": -4, "endianness": "big"}
+// verifies a trailing big endian CRC32C over every byte before it, and
+//   {"algorithm": "ones_complement16", "offset": 6, "begin": 8}
+// an Internet-style 16-bit ones'-complement sum stored at byte 6 over bytes 8 to the end.
+// "offset" and "end" are relative to the record start, or to its end if negative; "end"
+// defaults to the checksum's own offset when it trails the payload, else to the record end.
+struct PacketChecksum {
+    enum class Algorithm { kCrc32c, kCrc32, kOnesComplement16 };
+
+    Algorithm algorithm = Algorithm::kCrc32c;
+    int64_t offset = -4;
+    size_t begin = 0;
+    int64_t end = 0;
+    bool has_end = false;
+    bool little_endian = true;  // byte order of the stored value and of the summed words
+
+    // Returns false (after logging) if the configuration is incomplete or inconsistent
+    static bool FromJson(const nlohmann::json& config, PacketChecksum& checksum);
+
+    // Bytes of the stored value
+    size_t Size() const { return algorithm == Algorithm::kOnesComplement16 ? 2 : 4; }
+
+    // True if the record's stored checksum matches its covered bytes. Records too short to
+    // hold the checksum or the covered range fail.
+    bool Verify(const uint8_t* record, size_t record_length) const;
+};
+
+// Checksum kernels, chosen once for the running CPU like the magic search in PacketScanner
+namespace Checksum {
+
+// CRC32C (Castagnoli), with the SSE4.2 crc32 instruction when available
+uint32_t Crc32c(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+// CRC32 (IEEE 802.3, as in zlib), slicing by 8 bytes
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+// Ones'-complement sum of 16-bit words, folded to 16 bits; an odd trailing byte is padded
+// with zero. The complement of the sum is what RFC 1071 stores.
+uint16_t OnesComplementSum16(const uint8_t* data, size_t size, bool little_endian);
+
+// "avx2", "sse2" or "scalar" for sums; "sse4.2" or "scalar" for CRC32C
+const char* ActiveSumKernelName();
+const char* ActiveCrc32cKernelName();
+
+} // namespace Checksum
+
+#endif // UNPACKER_CORE_UTILS_PACKET_CHECKSUM_H
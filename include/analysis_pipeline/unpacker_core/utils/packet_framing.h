@@ -0,0 +1,80 @@
+#ifndef UNPACKER_CORE_UTILS_PACKET_FRAMING_H
+#define UNPACKER_CORE_UTILS_PACKET_FRAMING_H
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// How records are laid out back to back in a ByteStream bank: an optional header magic,
+// and either a fixed stride or a length field in the record header. For example
+//   {"magic": "0xAA55", "length_offset": 2, "length_size": 2, "length_endianness": "big",
+//    "length_unit": 4, "length_adjust": 4}
+// frames records that start with AA 55 followed by a big endian word count that does not
+// include the 4-byte header itself.
+struct PacketFraming {
+    std::vector<uint8_t> magic;  // bytes in stream order; empty means records are not tagged
+    size_t magic_offset = 0;     // position of the magic inside the record
+
+    size_t stride = 0;           // fixed record size, used when length_size is 0
+    size_t length_offset = 0;
+    size_t length_size = 0;      // 1, 2, 4 or 8 bytes
+    bool length_little_endian = true;
+    size_t length_unit = 1;      // bytes per length count
+    int64_t length_adjust = 0;   // added to length * length_unit
+
+    // On a bad magic or length, search forward for the next magic instead of stopping
+    bool resync = true;
+
+    // Returns false (after logging) if the configuration is incomplete or inconsistent
+    static bool FromJson(const nlohmann::json& config, PacketFraming& framing);
+
+    // Size of the record starting at `record`, or 0 if the header is truncated or its
+    // length is implausible (shorter than the header, or beyond 4 GiB)
+    size_t RecordLength(const uint8_t* record, size_t available) const;
+
+    // Bytes a record needs before its length can be read and its magic checked
+    size_t HeaderSize() const;
+
+    // True if the last `available` bytes of a bank can be the head of a record that
+    // continues in the next one: a cut-off header whose magic matches as far as it goes, or
+    // a tagged header whose length runs past the bank end
+    bool IsTruncatedRecord(const uint8_t* record, size_t available) const;
+
+    // Length of the record whose header starts at `record`, or 0 if its magic or length is
+    // invalid. Reads HeaderSize() bytes.
+    size_t HeaderLength(const uint8_t* record) const;
+};
+
+class PacketScanner {
+public:
+    struct Result {
+        size_t end_offset = 0;     // first byte not covered by a complete record
+        size_t skipped_bytes = 0;  // bytes passed over while resynchronizing
+    };
+
+    // Frames the bank from start_offset, appending each complete record's offset and length.
+    // Scanning ends at the buffer end, at a truncated trailing record, or at the first
+    // malformed record when resync is off or no further magic is found.
+    static Result Scan(const uint8_t* data,
+                       size_t data_size,
+                       size_t start_offset,
+                       const PacketFraming& framing,
+                       std::vector<uint64_t>& offsets,
+                       std::vector<uint32_t>& lengths);
+
+    // Offset of the first occurrence of magic at or after `from`, or data_size if none.
+    // Candidates are found 32 (AVX2) or 16 (SSE2) bytes at a time by matching the first and
+    // last magic bytes, then confirmed with memcmp.
+    static size_t FindMagic(const uint8_t* data,
+                            size_t data_size,
+                            size_t from,
+                            const uint8_t* magic,
+                            size_t magic_size);
+
+    // "avx2", "sse2" or "scalar"
+    static const char* ActiveKernelName();
+};
+
+#endif // UNPACKER_CORE_UTILS_PACKET_FRAMING_H
@@ -0,0 +1,59 @@
+#ifndef UNPACKER_CORE_UTILS_RECORD_CARRY_H
+#define UNPACKER_CORE_UTILS_RECORD_CARRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// The head of one record cut off at the end of a ByteStream bank, kept until the next bank
+// completes it. Only that record's bytes are copied, never the banks around it, so
+// everything before and after the cut is still decoded in place. The buffer is reused and
+// grows to the largest record carried so far, up to max_record_bytes.
+class RecordCarry {
+public:
+    enum class Status {
+        kEmpty,       // nothing was carried
+        kComplete,    // Data() holds the whole record
+        kIncomplete,  // the bank ended first; the record stays carried
+        kMalformed    // the completed header is not a valid record; the carried bytes are dropped
+    };
+
+    // Length of the record whose header starts at `record`, or 0 if the header is invalid.
+    // Only the first header_size bytes are readable.
+    using LengthFn = std::function<size_t(const uint8_t* record)>;
+
+    explicit RecordCarry(size_t max_record_bytes = size_t(1) << 20);
+
+    // Carries bytes [offset, bank_size) of a bank. Returns false, keeping nothing, if they
+    // are more than max_record_bytes.
+    bool Stash(const uint8_t* bank, size_t bank_size, size_t offset);
+
+    // Appends bytes from the head of the next bank until the header is complete, then until
+    // the record is. consumed receives the bank bytes taken: all of them while incomplete,
+    // none for a malformed record, so the bank is framed from its start again.
+    Status Complete(const uint8_t* bank,
+                    size_t bank_size,
+                    size_t header_size,
+                    const LengthFn& length_of,
+                    size_t& consumed);
+
+    const uint8_t* Data() const { return bytes_.data(); }
+    size_t Size() const { return bytes_.size(); }
+    bool Pending() const { return !bytes_.empty(); }
+
+    size_t GetMaxRecordBytes() const { return max_record_bytes_; }
+    void SetMaxRecordBytes(size_t max_record_bytes) { max_record_bytes_ = max_record_bytes; }
+
+    // Drops the carried bytes, e.g. when the stream restarts; keeps the allocation
+    void Clear();
+
+private:
+    void Append(const uint8_t* bank, size_t bank_size, size_t& consumed, size_t target);
+
+    std::vector<uint8_t> bytes_;
+    size_t record_length_ = 0;  // 0 until the header is complete
+    size_t max_record_bytes_;
+};
+
+#endif // UNPACKER_CORE_UTILS_RECORD_CARRY_H
@@ -0,0 +1,95 @@
+#ifndef UNPACKER_CORE_UTILS_RECORD_DISPATCH_H
+#define UNPACKER_CORE_UTILS_RECORD_DISPATCH_H
+
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+
+#include <TClass.h>
+#include <TClonesArray.h>
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Decoder for banks that interleave several record kinds told apart by a type tag in each
+// record's header. For example
+//   {"tag": {"offset": 0, "size": 1, "mask": "0xF0", "shift": 4},
+//    "types": [{"tag": 1, "class": "Header", "mapping": {...}},
+//              {"tag": 2, "class": "Hit", "record_size": 12, "product_name": "hits"},
+//              {"tag": "0xF", "class": "Trailer", "endianness": "big"}],
+//    "on_unknown": "skip", "skip_bytes": 4}
+// Each type is compiled once into a plan; a type without "mapping" is reflected with
+// "endianness" and "field_overrides" like ReflectionBasedParser. Tags index a dense table,
+// so one pass over the bank decodes every record with a single lookup each. A record
+// occupies "record_size" bytes (default: its plan's extent) or, with vector fields, the
+// bytes it decoded.
+class RecordDispatchTable {
+public:
+    struct Type {
+        uint64_t tag = 0;
+        TClass* cls = nullptr;
+        std::shared_ptr<const CompiledParsePlan> plan;
+        size_t record_size = 0;
+        std::string product_name;  // default: class name; must be unique in the table
+    };
+
+    struct Result {
+        size_t records = 0;             // records decoded, over all types
+        size_t end_offset = 0;          // first byte not consumed
+        size_t skipped_records = 0;     // unknown tags passed over with "on_unknown": "skip"
+        bool unknown_tag = false;       // stopped at a tag with no type
+        const Type* failed = nullptr;   // stopped at a record of this type that did not decode
+    };
+
+    // Returns false (after logging) if the table or any of its types is invalid
+    static bool FromJson(const nlohmann::json& config, RecordDispatchTable& table);
+
+    const std::vector<Type>& GetTypes() const { return types_; }
+
+    // Index of the type for a tag, or -1
+    int Find(uint64_t tag) const {
+        if (!dense_.empty()) {
+            return tag < dense_.size() ? dense_[tag] : -1;
+        }
+        auto it = sparse_.find(tag);
+        return it != sparse_.end() ? it->second : -1;
+    }
+
+    // Tag of the record starting at `record`; tag_end bytes must be readable
+    uint64_t ReadTag(const uint8_t* record) const;
+
+    // Bytes from a record's start that must be present to read its tag
+    size_t TagEnd() const { return tag_offset_ + tag_size_; }
+
+    // Decodes records back to back from start_offset into outputs[i] for types_[i], appending
+    // to what the arrays hold. Stops at the buffer end, a truncated record, a record that
+    // fails to decode, or an unknown tag unless unknown tags are skipped. With check_fields,
+    // records are decoded with CompiledParsePlan::ExecuteChecked().
+    Result Decode(const uint8_t* data,
+                  size_t data_size,
+                  size_t start_offset,
+                  const std::vector<TClonesArray*>& outputs,
+                  bool check_fields = false) const;
+
+private:
+    // Tags up to this value use the dense table
+    static constexpr uint64_t kMaxDenseTag = 4095;
+
+    std::vector<Type> types_;
+    std::vector<int> dense_;
+    std::unordered_map<uint64_t, int> sparse_;
+
+    size_t tag_offset_ = 0;
+    size_t tag_size_ = 1;
+    bool tag_swap_ = false;
+    uint64_t tag_mask_ = ~uint64_t(0);
+    unsigned tag_shift_ = 0;
+
+    bool skip_unknown_ = false;
+    size_t skip_bytes_ = 1;
+};
+
+#endif // UNPACKER_CORE_UTILS_RECORD_DISPATCH_H
@@ -0,0 +1,96 @@
+#ifndef UNPACKER_CORE_UTILS_RECORD_PREDICATE_H
+#define UNPACKER_CORE_UTILS_RECORD_PREDICATE_H
+
+#include "analysis_pipeline/unpacker_core/utils/bit_unpack.h"
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Selection cut evaluated on an encoded record before it is decoded, e.g.
+//   adc > 50 && channel != 17 && !(flags & 0x4) && samples[0] < 4000
+// Identifiers name mapped fields of a compiled plan, with [i] for an element of an
+// array<T,N> field; literals are decimal, hex or floating point. Operators are ==, !=, <,
+// <=, >, >=, & (integers), !, && and || with C precedence, and parentheses. A bare value
+// is true when non-zero. Unsigned fields compare as unsigned 64-bit values, and a
+// negative signed value is below every unsigned one. Only the referenced fields are read,
+// straight from the buffer with the mapping's byte order, so rejected records cost no
+// allocation and no field copies. Vector fields, fields placed after them and
+// custom-handler types cannot be referenced.
+class RecordPredicate {
+public:
+    // Returns nullptr (after logging) if the expression does not parse or references a
+    // field the plan cannot read in place
+    static std::shared_ptr<const RecordPredicate> Compile(const std::string& expression,
+                                                          const CompiledParsePlan& plan);
+
+    // True if the record at start_offset passes. A record too short to hold the referenced
+    // fields passes, so that decoding it reports the error.
+    bool Matches(const uint8_t* buffer, size_t buffer_size, size_t start_offset) const;
+
+    const std::string& GetExpression() const { return expression_; }
+
+private:
+    using Kind = CompiledParsePlan::ValueKind;
+
+    struct Value {
+        Kind kind = Kind::kSigned;
+        uint64_t bits = 0;  // two's complement for kSigned
+        double f = 0.0;     // kFloat only
+
+        int64_t Signed() const { return static_cast<int64_t>(bits); }
+        double AsDouble() const {
+            return kind == Kind::kFloat ? f : kind == Kind::kUnsigned ? static_cast<double>(bits)
+                                                                      : static_cast<double>(Signed());
+        }
+        bool Truthy() const { return kind == Kind::kFloat ? f != 0.0 : bits != 0; }
+    };
+
+    // -1, 0 or 1, or 2 if a NaN makes the operands unordered
+    static int Compare(const Value& lhs, const Value& rhs);
+
+    struct FieldLoad {
+        int64_t source_offset = 0;  // relative to the record start; negative counts from the buffer end
+        size_t size = 0;            // bytes read at source_offset
+        size_t element_size = 0;
+        bool swap = false;
+        Kind kind = Kind::kSigned;
+
+        // Bit fields and packed arrays
+        bool bit_field = false;
+        BitUnpack::FieldSpec bits;
+        size_t bit_offset = 0;
+        size_t bit_width = 0;
+        bool big_endian = false;
+        bool sign_extend = false;
+    };
+
+    enum class Op : uint8_t { kConst, kField, kEq, kNe, kLt, kLe, kGt, kGe, kBitAnd, kNot, kAnd, kOr };
+
+    struct Node {
+        Op op = Op::kConst;
+        int lhs = -1;
+        int rhs = -1;
+        Value constant;
+        FieldLoad field;
+    };
+
+    class Parser;
+
+    RecordPredicate() = default;
+
+    // Field layouts are copied into the nodes, so the plan is only needed while compiling
+    Value Eval(int node, const uint8_t* record, const uint8_t* buffer_end) const;
+    static Value Load(const FieldLoad& field, const uint8_t* src);
+
+    std::string expression_;
+    std::vector<Node> nodes_;
+    int root_ = -1;
+    size_t extent_ = 0;              // bytes past the record start read by record-relative fields
+    size_t end_extent_ = 0;          // bytes before the buffer end read by end-relative fields
+};
+
+#endif // UNPACKER_CORE_UTILS_RECORD_PREDICATE_H
@@ -0,0 +1,91 @@
+#ifndef UNPACKER_CORE_UTILS_RECORD_VIEW_H
+#define UNPACKER_CORE_UTILS_RECORD_VIEW_H
+
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+
+#include <TObject.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Zero-copy view of one encoded record. Fields are decoded from the underlying buffer on
+// access, with the byte order of the compiled layout, and a full object is only built on
+// Materialize(). The view does not own the buffer or the plan; both must outlive it.
+class RecordView {
+public:
+    RecordView() = default;
+    RecordView(const CompiledParsePlan* plan, const uint8_t* buffer, size_t buffer_size, size_t start_offset)
+        : plan_(plan), buffer_(buffer), buffer_size_(buffer_size), start_offset_(start_offset) {}
+
+    // Decode a scalar field by its index in plan->GetFields(). Returns false if the field
+    // (or, for bit fields, its member) is not sizeof(T) wide, does not hold T's kind of
+    // value (signed, unsigned or floating point; bits are never reinterpreted between
+    // them), is handled by a custom TypeRegistry handler, is out of bounds, or only has a
+    // per-record position (vectors and fields placed after them; use Materialize for those).
+    template<typename T>
+    bool Get(size_t field_index, T& out) const {
+        return GetElement(field_index, 0, out);
+    }
+
+    // Same for one element of an array<T,N> field
+    template<typename T>
+    bool GetElement(size_t field_index, size_t element, T& out) const {
+        static_assert(std::is_arithmetic_v<T>, "RecordView reads arithmetic values");
+        if (!HoldsKindOf<T>(field_index)) {
+            return false;
+        }
+        if (IsBitField(field_index)) {
+            uint64_t bits;
+            if (!ReadBits(field_index, element, sizeof(T), bits)) {
+                return false;
+            }
+            out = static_cast<T>(bits);
+            return true;
+        }
+        const uint8_t* src = ElementAddress(field_index, element, sizeof(T));
+        if (!src) {
+            return false;
+        }
+        out = ByteSwap::Load<T>(src, plan_->GetFields()[field_index].swap);
+        return true;
+    }
+
+    // Decode every mapped field into obj, exactly as the eager path would
+    bool Materialize(TObject* obj) const;
+
+    const CompiledParsePlan* GetPlan() const { return plan_; }
+    size_t GetStartOffset() const { return start_offset_; }
+
+private:
+    template<typename T>
+    bool HoldsKindOf(size_t field_index) const {
+        if (!plan_ || field_index >= plan_->GetFields().size()) {
+            return false;
+        }
+        using Kind = CompiledParsePlan::ValueKind;
+        const Kind kind = plan_->GetFields()[field_index].value_kind;
+        if constexpr (std::is_floating_point_v<T>) {
+            return kind == Kind::kFloat;
+        } else if constexpr (std::is_signed_v<T>) {
+            return kind == Kind::kSigned;
+        } else {
+            return kind == Kind::kUnsigned;
+        }
+    }
+
+    bool IsBitField(size_t field_index) const {
+        return plan_ && field_index < plan_->GetFields().size() && plan_->GetFields()[field_index].bit_width;
+    }
+    const uint8_t* FieldAddress(const CompiledParsePlan::FieldOp& field) const;
+    const uint8_t* ElementAddress(size_t field_index, size_t element, size_t width) const;
+    bool ReadBits(size_t field_index, size_t element, size_t width, uint64_t& out) const;
+
+    const CompiledParsePlan* plan_ = nullptr;
+    const uint8_t* buffer_ = nullptr;
+    size_t buffer_size_ = 0;
+    size_t start_offset_ = 0;
+};
+
+#endif // UNPACKER_CORE_UTILS_RECORD_VIEW_H
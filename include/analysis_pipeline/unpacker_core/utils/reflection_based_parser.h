@@ -1,15 +1,23 @@
 #ifndef REFLECTION_BASED_PARSER_H
 #define REFLECTION_BASED_PARSER_H
 
+#include <memory>
 #include <string>
 #include <nlohmann/json.hpp>
 #include <TObject.h>
 
 class FieldMappingParser;
+class CompiledParsePlan;
 
 class ReflectionBasedParser {
 public:
-    ReflectionBasedParser(std::string class_name, std::string default_endianness = "little");
+    // field_overrides is merged over the generated per-member entries, e.g.
+    // {"channel": {"bit_offset": 0, "bit_width": 12}} to decode a sub-byte field, or
+    // {"samples": {"count_from": "nsamples"}} to decode a vector member; members declared
+    // after a vector are then placed after it.
+    ReflectionBasedParser(std::string class_name,
+                          std::string default_endianness = "little",
+                          nlohmann::json field_overrides = nlohmann::json::object());
     ~ReflectionBasedParser();
 
     bool Parse(const uint8_t* buffer,
@@ -17,13 +25,19 @@ public:
                size_t start_offset,
                TObject* obj) const;
 
+    // Record size in bytes; for classes with vector fields, the fixed-size fields only
     size_t GetTotalParsedSize() const { return total_parsed_size_; }
 
+    const nlohmann::json& GetFieldMapping() const { return json_field_mapping_; }
+    const std::shared_ptr<const CompiledParsePlan>& GetPlan() const { return plan_; }
+
 private:
     std::string class_name_;
     std::string default_endianness_;
+    nlohmann::json field_overrides_;
     nlohmann::json json_field_mapping_;
     FieldMappingParser* delegate_;
+    std::shared_ptr<const CompiledParsePlan> plan_;
 
     size_t total_parsed_size_ = 0;
 
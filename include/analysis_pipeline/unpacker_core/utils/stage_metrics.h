@@ -0,0 +1,107 @@
+#ifndef UNPACKER_CORE_UTILS_STAGE_METRICS_H
+#define UNPACKER_CORE_UTILS_STAGE_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Set by the UNPACKER_STAGES_CORE_ENABLE_METRICS CMake option
+#ifndef UNPACKER_STAGES_CORE_METRICS
+#define UNPACKER_STAGES_CORE_METRICS 1
+#endif
+
+// Hot-path counters for one stage. Every thread that records into an instance gets its own
+// cache-line sized slot, so decode workers never contend on a shared counter; Collect()
+// sums and resets the slots. With UNPACKER_STAGES_CORE_METRICS=0 every call is an empty
+// inline function and no clock is read. The class layout is the same either way.
+class StageMetrics {
+public:
+    enum Counter : size_t {
+        kBytesConsumed,
+        kRecordsDecoded,
+        kDecodeFailures,
+        kLockWaitNs,
+        kDecodeNs,
+        kChecksumFailures,
+        kRecordsAccepted,   // records passing the stage's selection cut
+        kRecordsRejected,   // records skipped by it before decoding
+        kRecordsCarried,    // records completed from a previous bank's tail
+        kNumCounters
+    };
+
+    struct Totals {
+        uint64_t values[kNumCounters] = {};
+        std::map<std::string, uint64_t> field_failures;  // "<class>.<field>" -> count
+    };
+
+    static constexpr bool kEnabled = UNPACKER_STAGES_CORE_METRICS != 0;
+
+    StageMetrics();
+    ~StageMetrics();
+
+    StageMetrics(const StageMetrics&) = delete;
+    StageMetrics& operator=(const StageMetrics&) = delete;
+
+    void Add(Counter counter, uint64_t value) {
+        if (kEnabled) {
+            LocalSlot().values[counter].fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    // Failures are rare, so they are keyed by name under a lock
+    void AddFieldFailure(const std::string& field) {
+        if (kEnabled) {
+            RecordFieldFailure(field);
+        }
+    }
+
+    // Adds every thread's counts since the last call to totals and resets them
+    void Collect(Totals& totals);
+
+    // Adds the elapsed nanoseconds to a counter when it goes out of scope
+    class ScopedTimer {
+    public:
+        ScopedTimer(StageMetrics& metrics, Counter counter) : metrics_(metrics), counter_(counter) {
+            if (kEnabled) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+        ~ScopedTimer() {
+            if (kEnabled) {
+                const auto elapsed = std::chrono::steady_clock::now() - start_;
+                metrics_.Add(counter_, static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        StageMetrics& metrics_;
+        Counter counter_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> values[kNumCounters] = {};
+    };
+
+    Slot& LocalSlot();
+    void RecordFieldFailure(const std::string& field);
+
+    const uint64_t id_;  // never reused, so a thread's cached slot cannot outlive its owner's identity
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::map<std::string, uint64_t> field_failures_;
+};
+
+#endif // UNPACKER_CORE_UTILS_STAGE_METRICS_H
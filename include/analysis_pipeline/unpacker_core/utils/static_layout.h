@@ -0,0 +1,212 @@
+#ifndef UNPACKER_CORE_UTILS_STATIC_LAYOUT_H
+#define UNPACKER_CORE_UTILS_STATIC_LAYOUT_H
+
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+
+#include <TClass.h>
+#include <TDataMember.h>
+#include <TList.h>
+#include <TRealData.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+
+// Record layouts known at build time, decoded without JSON, reflection or type-erased
+// handlers. For example
+//
+//   using HitLayout = StaticLayout<Field<&Hit::fChannel, 0, uint16_t, BigEndian>,
+//                                  Field<&Hit::fTime,    2, uint32_t, BigEndian>,
+//                                  Field<&Hit::fSamples, 6, uint16_t, BigEndian>>;
+//
+// Each Field names a member, its byte offset in the record and its type on the wire, which
+// may be narrower or wider than the member. A std::array<T,N> member reads N consecutive
+// wire values. Decode() compiles to straight-line loads, byte swaps and stores.
+// Verify() checks a layout against the class's ROOT reflection, and optionally against the
+// JSON mapping it replaces, so a layout that drifts from the class fails at startup.
+
+struct LittleEndian {
+    static constexpr bool kLittle = true;
+};
+
+struct BigEndian {
+    static constexpr bool kLittle = false;
+};
+
+namespace static_layout_detail {
+
+template<typename T>
+struct MemberPointer;
+
+template<typename C, typename M>
+struct MemberPointer<M C::*> {
+    using Class = C;
+    using Member = M;
+};
+
+template<typename M>
+struct ElementCount {
+    using Element = M;
+    static constexpr size_t kCount = 1;
+};
+
+template<typename E, size_t N>
+struct ElementCount<std::array<E, N>> {
+    using Element = E;
+    static constexpr size_t kCount = N;
+};
+
+constexpr bool kHostLittleEndian = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+} // namespace static_layout_detail
+
+template<auto MemberPtr, size_t Offset, typename Wire, typename Order = LittleEndian>
+struct Field {
+    using Traits = static_layout_detail::MemberPointer<decltype(MemberPtr)>;
+    using Class = typename Traits::Class;
+    using Member = typename Traits::Member;
+    using Element = typename static_layout_detail::ElementCount<Member>::Element;
+
+    static constexpr size_t kOffset = Offset;
+    static constexpr size_t kCount = static_layout_detail::ElementCount<Member>::kCount;
+    static constexpr size_t kWireSize = sizeof(Wire);
+    static constexpr size_t kEnd = Offset + kCount * sizeof(Wire);
+    static constexpr bool kLittle = Order::kLittle;
+    static constexpr bool kSwap = (Order::kLittle != static_layout_detail::kHostLittleEndian);
+
+    static_assert(std::is_arithmetic_v<Wire>, "Field wire type must be an integer or floating point type");
+    static_assert(std::is_arithmetic_v<Element>, "Field member must be arithmetic or a std::array of arithmetic");
+    static_assert(sizeof(Wire) == 1 || sizeof(Wire) == 2 || sizeof(Wire) == 4 || sizeof(Wire) == 8,
+                  "Field wire type must be 1, 2, 4 or 8 bytes");
+
+    static inline void Decode(const uint8_t* record, Class& obj) {
+        if constexpr (kCount == 1) {
+            obj.*MemberPtr = static_cast<Element>(Load(record + Offset));
+        } else if constexpr (std::is_same_v<Wire, Element> && kSwap) {
+            ByteSwap::SwapArray((obj.*MemberPtr).data(), record + Offset, sizeof(Wire), kCount);
+        } else if constexpr (std::is_same_v<Wire, Element>) {
+            std::memcpy((obj.*MemberPtr).data(), record + Offset, kCount * sizeof(Wire));
+        } else {
+            auto& values = obj.*MemberPtr;
+            for (size_t i = 0; i < kCount; ++i) {
+                values[i] = static_cast<Element>(Load(record + Offset + i * sizeof(Wire)));
+            }
+        }
+    }
+
+    // Byte offset of the member inside Class, measured on a constructed instance since
+    // TObject-derived classes are not standard-layout. Only called by Verify().
+    static size_t MemberOffset() {
+        static_assert(std::is_default_constructible_v<Class>,
+                      "StaticLayout classes need a default constructor, as ROOT I/O does");
+        const auto object = std::make_unique<Class>();
+        const auto* base = reinterpret_cast<const unsigned char*>(object.get());
+        return static_cast<size_t>(reinterpret_cast<const unsigned char*>(&((*object).*MemberPtr)) - base);
+    }
+
+private:
+    static inline Wire Load(const uint8_t* src) {
+        return ByteSwap::Load<Wire>(src, kSwap);
+    }
+};
+
+template<typename First, typename... Rest>
+class StaticLayout {
+public:
+    using Class = typename First::Class;
+
+    static_assert((std::is_same_v<Class, typename Rest::Class> && ...),
+                  "All fields of a StaticLayout must belong to the same class");
+
+    static constexpr size_t kFieldCount = 1 + sizeof...(Rest);
+
+    // Bytes a record occupies, up to the end of the furthest field
+    static constexpr size_t kExtent = std::max({First::kEnd, Rest::kEnd...});
+
+    // No bounds checks: record must hold kExtent bytes
+    static inline void Decode(const uint8_t* record, Class& obj) {
+        First::Decode(record, obj);
+        (Rest::Decode(record, obj), ...);
+    }
+
+    static inline bool Decode(const uint8_t* buffer, size_t buffer_size, size_t start_offset, Class& obj) {
+        if (start_offset > buffer_size || kExtent > buffer_size - start_offset) {
+            return false;
+        }
+        Decode(buffer + start_offset, obj);
+        return true;
+    }
+
+    // Checks that cls is Class and every field maps to a data member of the declared size.
+    // With a mapping, each member must also appear there with the same offset, wire size and
+    // byte order. On mismatch, returns false and describes the first problem in error.
+    static bool Verify(TClass* cls, std::string& error, const nlohmann::json* mapping = nullptr) {
+        if (!cls) {
+            error = "null TClass";
+            return false;
+        }
+        if (cls != TClass::GetClass(typeid(Class))) {
+            error = std::string("layout is for a different class than '") + cls->GetName() + "'";
+            return false;
+        }
+        if (!VerifyField<First>(cls, error, mapping)) {
+            return false;
+        }
+        return (VerifyField<Rest>(cls, error, mapping) && ...);
+    }
+
+private:
+    template<typename F>
+    static bool VerifyField(TClass* cls, std::string& error, const nlohmann::json* mapping) {
+        const size_t offset = F::MemberOffset();
+        TDataMember* member = nullptr;
+        std::string name;
+        for (TIter it(cls->GetListOfRealData()); TRealData* rd = static_cast<TRealData*>(it()); ) {
+            if (static_cast<size_t>(rd->GetThisOffset()) == offset && rd->GetDataMember()) {
+                member = rd->GetDataMember();
+                name = rd->GetName();
+                break;
+            }
+        }
+        if (!member) {
+            error = "no data member of '" + std::string(cls->GetName()) + "' at object offset " + std::to_string(offset);
+            return false;
+        }
+        if (static_cast<size_t>(member->GetUnitSize()) != sizeof(typename F::Member)) {
+            error = "member '" + name + "' is " + std::to_string(member->GetUnitSize()) +
+                    " bytes, the layout declares " + std::to_string(sizeof(typename F::Member));
+            return false;
+        }
+
+        if (!mapping) {
+            return true;
+        }
+        auto it = mapping->find(name);
+        if (it == mapping->end()) {
+            error = "member '" + name + "' is not in the field mapping";
+            return false;
+        }
+        // A mapping may leave "size" out and take it from the member type
+        const int64_t mapped_offset = it->value("offset", static_cast<int64_t>(-1));
+        const size_t mapped_size = it->value("size", F::kCount * F::kWireSize);
+        const bool mapped_little = it->value("endianness", std::string("little")) == "little";
+        if (mapped_offset != static_cast<int64_t>(F::kOffset) || mapped_size != F::kCount * F::kWireSize ||
+            mapped_little != F::kLittle || it->contains("bit_width")) {
+            error = "member '" + name + "' is mapped at offset " + std::to_string(mapped_offset) + ", size " +
+                    std::to_string(mapped_size) + ", but the layout has offset " + std::to_string(F::kOffset) +
+                    ", size " + std::to_string(F::kCount * F::kWireSize) + (F::kLittle ? ", little" : ", big") +
+                    " endian";
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif // UNPACKER_CORE_UTILS_STATIC_LAYOUT_H
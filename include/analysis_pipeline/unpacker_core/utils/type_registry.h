@@ -5,12 +5,16 @@
 #include <unordered_map>
 #include <functional>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
 #include <TObject.h>
 #include <TDataMember.h>
 #include <cstring>
 #include <algorithm>
-#include <regex>
+#include <shared_mutex>
+#include <unordered_set>
+#include <vector>
 
 class TypeRegistry {
 public:
@@ -21,12 +25,38 @@ public:
                                            TObject* obj,
                                            TDataMember* member)>;
 
+    // Copies `count` elements from an unaligned source into a member, converting byte order if needed
+    using CopyKernel = void (*)(void* dst, const uint8_t* src, size_t count);
+
+    // Resizes a std::vector<T> member to `count` elements, keeping its capacity, and returns its data
+    using VectorResize = uint8_t* (*)(void* vec, size_t count);
+
     static TypeRegistry& Instance();
 
     HandlerFunc GetHandler(const std::string& type_name) const;
 
+    // Registered or resolved handler, or nullptr if the type is unknown. array<T,N> types are
+    // parsed once and cached; the returned pointer stays valid for the registry's lifetime.
+    // Registering a type again does not touch handlers already returned: later lookups get
+    // the new handler, while plans compiled earlier keep calling the one they resolved.
+    const HandlerFunc* FindHandler(const std::string& type_name) const;
+
     void RegisterHandler(const std::string& type_name, HandlerFunc handler);
 
+    // True if the type was registered through RegisterHandler and must go through its handler
+    bool HasCustomHandler(const std::string& type_name) const;
+
+    // Resolve a built-in scalar or array<T,N> type into element size and element count
+    bool ResolveLayout(const std::string& type_name, size_t& element_size, size_t& count) const;
+
+    // Resolve a vector<T> member with a built-in element type. vector<bool> is not supported.
+    bool ResolveVectorLayout(const std::string& type_name, size_t& element_size, VectorResize& resize) const;
+
+    // Kernel for elements of the given width; nullptr if the width is not supported
+    static CopyKernel GetCopyKernel(size_t element_size, bool swap);
+
+    bool IsSystemLittleEndian() const { return system_little_endian_; }
+
 private:
     TypeRegistry();
     TypeRegistry(const TypeRegistry&) = delete;
@@ -34,8 +64,24 @@ private:
 
     bool system_little_endian_;
 
-    std::unordered_map<std::string, HandlerFunc> handlers_;
+    // Every handler ever registered, never erased, so pointers into it stay valid
+    std::deque<HandlerFunc> handler_storage_;
+    std::unordered_map<std::string, const HandlerFunc*> handlers_;
     std::unordered_map<std::string, size_t> sizes_;
+    std::unordered_map<std::string, VectorResize> vector_resizers_;
+    std::unordered_set<std::string> custom_types_;
+
+    // Handlers built on demand for array<T,N> types; null entries cache unknown types
+    mutable std::deque<HandlerFunc> resolved_storage_;
+    mutable std::unordered_map<std::string, const HandlerFunc*> resolved_handlers_;
+    mutable std::shared_mutex mutex_;
+
+    template<typename T>
+    static uint8_t* ResizeVector(void* vec, size_t count) {
+        auto& values = *static_cast<std::vector<T>*>(vec);
+        values.resize(count);
+        return reinterpret_cast<uint8_t*>(values.data());
+    }
 
     template<typename T>
     bool ReadValue(const uint8_t* buffer, size_t buffer_size, size_t offset, bool little_endian, T& out_value) const {
@@ -58,9 +104,41 @@ private:
         return true;
     }
 
-    static void SwapBytes(void* data, size_t size);
+    // Inline so that ReadValue<T> folds to a single bswap for its constant size
+    static void SwapBytes(void* data, size_t size) {
+        switch (size) {
+            case 2: {
+                uint16_t v;
+                std::memcpy(&v, data, sizeof(v));
+                v = ByteSwap::Swap16(v);
+                std::memcpy(data, &v, sizeof(v));
+                return;
+            }
+            case 4: {
+                uint32_t v;
+                std::memcpy(&v, data, sizeof(v));
+                v = ByteSwap::Swap32(v);
+                std::memcpy(data, &v, sizeof(v));
+                return;
+            }
+            case 8: {
+                uint64_t v;
+                std::memcpy(&v, data, sizeof(v));
+                v = ByteSwap::Swap64(v);
+                std::memcpy(data, &v, sizeof(v));
+                return;
+            }
+            default:
+                ByteSwap::SwapArray(data, data, size, 1);
+                return;
+        }
+    }
 
     size_t GetTypeSize(const std::string& type_name) const;
+
+    HandlerFunc ResolveArrayHandler(const std::string& type_name) const;
+
+    static bool ParseArrayType(const std::string& type_name, std::string& base_type, size_t& count);
 };
 
 #endif // UNPACKER_CORE_UTILS_TYPE_REGISTRY_H
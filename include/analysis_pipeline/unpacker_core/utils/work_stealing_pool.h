@@ -0,0 +1,65 @@
+#ifndef UNPACKER_CORE_UTILS_WORK_STEALING_POOL_H
+#define UNPACKER_CORE_UTILS_WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed set of worker threads for splitting a range of independent records. Each worker
+// drains its own queue from the back and steals from the front of the others' queues when
+// it runs dry; the calling thread takes part as one more worker.
+class WorkStealingPool {
+public:
+    using RangeFunc = std::function<void(size_t begin, size_t end)>;
+
+    // num_threads counts the calling thread, so 1 runs everything inline
+    explicit WorkStealingPool(size_t num_threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Runs fn over [0, count) in chunks of at least min_chunk elements and returns when all
+    // chunks are done. Chunks are disjoint, so writes indexed by element need no locking.
+    // An exception thrown by fn is rethrown here once every chunk has finished.
+    void ParallelFor(size_t count, size_t min_chunk, const RangeFunc& fn);
+
+    size_t GetThreadCount() const { return queues_.size(); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::pair<size_t, size_t>> ranges;
+    };
+
+    void WorkerLoop(size_t index);
+    bool RunOne(size_t index);
+    bool PopLocal(size_t index, std::pair<size_t, size_t>& range);
+    bool Steal(size_t thief, std::pair<size_t, size_t>& range);
+
+    std::vector<std::unique_ptr<Queue>> queues_;  // last queue belongs to the calling thread
+    std::vector<std::thread> workers_;
+
+    std::mutex job_mutex_;  // one ParallelFor at a time
+    std::atomic<const RangeFunc*> job_{nullptr};
+    std::atomic<size_t> pending_{0};
+
+    std::mutex error_mutex_;
+    std::exception_ptr error_;  // first exception thrown by a chunk, rethrown by ParallelFor
+    size_t generation_ = 0;
+    bool stopping_ = false;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+};
+
+#endif // UNPACKER_CORE_UTILS_WORK_STEALING_POOL_H
@@ -8,6 +8,7 @@ CLEANUP_SCRIPT="$SCRIPT_DIR/cleanup.sh"
 
 # Default flags
 OVERWRITE=false
+BENCHMARKS=OFF
 JOBS_ARG="-j"  # Use all processors
 
 # Help message
@@ -17,6 +18,7 @@ show_help() {
     echo "Options:"
     echo "  -o, --overwrite           Remove existing build directory before building"
     echo "  -j, --jobs <number>       Specify number of processors to use (default: all available)"
+    echo "  -b, --benchmarks          Also build the unpacker_stages_core_bench benchmark suite"
     echo "  -h, --help                Display this help message"
 }
 
@@ -36,6 +38,10 @@ while [[ "$#" -gt 0 ]]; do
                 shift
             fi
             ;;
+        -b|--benchmarks)
+            BENCHMARKS=ON
+            shift
+            ;;
         -h|--help)
             show_help
             exit 0
@@ -60,7 +66,7 @@ cd "$BUILD_DIR" || exit 1
 
 # Run CMake and Make
 echo "[build.sh] Running cmake in: $BUILD_DIR"
-cmake "$BASE_DIR"
+cmake "$BASE_DIR" -DUNPACKER_STAGES_CORE_BUILD_BENCHMARKS=$BENCHMARKS
 
 echo "[build.sh] Building with make $JOBS_ARG"
 make $JOBS_ARG
@@ -0,0 +1,51 @@
+#include "analysis_pipeline/unpacker_core/data_products/ColumnarRecordBatch.h"
+
+#include <new>
+
+ClassImp(ColumnarRecordBatch)
+
+void ColumnarRecordBatch::Reset(std::shared_ptr<const CompiledParsePlan> plan, size_t records) {
+    if (plan != plan_) {
+        plan_ = std::move(plan);
+        columns_.clear();
+        if (plan_) {
+            for (const auto& field : plan_->GetFields()) {
+                Column column;
+                column.name = field.name;
+                column.element_size = field.element_size;
+                column.elements_per_record = field.count;
+                columns_.push_back(std::move(column));
+            }
+        }
+    }
+
+    size_t total = 0;
+    for (Column& column : columns_) {
+        column.offset = total;
+        const size_t bytes = records * column.elements_per_record * column.element_size;
+        total += (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    if (total > capacity_) {
+        void* p = std::aligned_alloc(kAlignment, total);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        storage_.reset(static_cast<uint8_t*>(p));
+        capacity_ = total;
+    }
+    records_ = records;
+}
+
+size_t ColumnarRecordBatch::FindColumn(const std::string& name) const {
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        if (columns_[i].name == name) {
+            return i;
+        }
+    }
+    return CompiledParsePlan::kNoField;
+}
+
+void ColumnarRecordBatch::Clear(Option_t*) {
+    records_ = 0;
+}
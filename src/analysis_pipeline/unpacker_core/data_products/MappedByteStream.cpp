@@ -0,0 +1,17 @@
+#include "analysis_pipeline/unpacker_core/data_products/MappedByteStream.h"
+
+ClassImp(MappedByteStream)
+
+MappedByteStream::MappedByteStream(std::shared_ptr<const MappedFile> file, size_t offset, size_t size)
+    : file_(std::move(file)), offset_(offset), size_(size) {}
+
+const std::string& MappedByteStream::GetSourcePath() const {
+    static const std::string kNone;
+    return file_ ? file_->Path() : kNone;
+}
+
+void MappedByteStream::Clear(Option_t*) {
+    file_.reset();
+    offset_ = 0;
+    size_ = 0;
+}
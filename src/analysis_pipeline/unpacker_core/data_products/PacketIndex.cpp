@@ -0,0 +1,17 @@
+#include "analysis_pipeline/unpacker_core/data_products/PacketIndex.h"
+
+ClassImp(PacketIndex)
+
+void PacketIndex::Build(const uint8_t* data, size_t data_size, size_t start_offset, const PacketFraming& framing) {
+    Clear();
+    const PacketScanner::Result result = PacketScanner::Scan(data, data_size, start_offset, framing, offsets_, lengths_);
+    end_offset_ = result.end_offset;
+    skipped_bytes_ = result.skipped_bytes;
+}
+
+void PacketIndex::Clear(Option_t*) {
+    offsets_.clear();
+    lengths_.clear();
+    end_offset_ = 0;
+    skipped_bytes_ = 0;
+}
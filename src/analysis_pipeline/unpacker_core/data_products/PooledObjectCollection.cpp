@@ -0,0 +1,13 @@
+#include "analysis_pipeline/unpacker_core/data_products/PooledObjectCollection.h"
+
+ClassImp(PooledObjectCollection)
+
+void PooledObjectCollection::Add(PooledObject obj) {
+    if (obj) {
+        objects_.push_back(std::move(obj));
+    }
+}
+
+void PooledObjectCollection::Clear(Option_t*) {
+    objects_.clear();
+}
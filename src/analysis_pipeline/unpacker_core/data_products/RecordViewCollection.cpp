@@ -0,0 +1,34 @@
+#include "analysis_pipeline/unpacker_core/data_products/RecordViewCollection.h"
+
+ClassImp(RecordViewCollection)
+
+RecordViewCollection::RecordViewCollection(std::shared_ptr<const CompiledParsePlan> plan,
+                                           std::shared_ptr<const void> owner,
+                                           const uint8_t* buffer,
+                                           size_t buffer_size)
+    : plan_(std::move(plan)), owner_(std::move(owner)), buffer_(buffer), buffer_size_(buffer_size) {}
+
+RecordViewCollection::RecordViewCollection(std::shared_ptr<const CompiledParsePlan> plan,
+                                           const uint8_t* buffer,
+                                           size_t buffer_size)
+    : plan_(std::move(plan)) {
+    auto copy = std::make_shared<std::vector<uint8_t>>(buffer, buffer + buffer_size);
+    buffer_ = copy->data();
+    buffer_size_ = copy->size();
+    owner_ = std::move(copy);
+}
+
+void RecordViewCollection::AddRecords(size_t start_offset, size_t stride, size_t count) {
+    offsets_.reserve(offsets_.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        offsets_.push_back(start_offset + i * stride);
+    }
+}
+
+size_t RecordViewCollection::FindField(const std::string& name) const {
+    return plan_ ? plan_->FindField(name) : CompiledParsePlan::kNoField;
+}
+
+void RecordViewCollection::Clear(Option_t*) {
+    offsets_.clear();
+}
@@ -0,0 +1,33 @@
+#include "analysis_pipeline/unpacker_core/data_products/StageMetricsSummary.h"
+
+ClassImp(StageMetricsSummary)
+
+void StageMetricsSummary::Add(const StageMetrics::Totals& totals, ULong64_t events) {
+    events_ += events;
+    bytes_consumed_ += totals.values[StageMetrics::kBytesConsumed];
+    records_decoded_ += totals.values[StageMetrics::kRecordsDecoded];
+    decode_failures_ += totals.values[StageMetrics::kDecodeFailures];
+    lock_wait_ns_ += totals.values[StageMetrics::kLockWaitNs];
+    decode_ns_ += totals.values[StageMetrics::kDecodeNs];
+    checksum_failures_ += totals.values[StageMetrics::kChecksumFailures];
+    records_accepted_ += totals.values[StageMetrics::kRecordsAccepted];
+    records_rejected_ += totals.values[StageMetrics::kRecordsRejected];
+    records_carried_ += totals.values[StageMetrics::kRecordsCarried];
+    for (const auto& [field, count] : totals.field_failures) {
+        field_failures_[field] += count;
+    }
+}
+
+void StageMetricsSummary::Clear(Option_t*) {
+    events_ = 0;
+    bytes_consumed_ = 0;
+    records_decoded_ = 0;
+    decode_failures_ = 0;
+    lock_wait_ns_ = 0;
+    decode_ns_ = 0;
+    checksum_failures_ = 0;
+    records_accepted_ = 0;
+    records_rejected_ = 0;
+    records_carried_ = 0;
+    field_failures_.clear();
+}
@@ -0,0 +1,152 @@
+#include "analysis_pipeline/unpacker_core/stages/byte_stream_file_replay_stage.h"
+#include "analysis_pipeline/core/data/pipeline_data_product_manager.h"
+#include "analysis_pipeline/core/data/pipeline_data_product.h"
+#include "analysis_pipeline/unpacker_core/data_products/MappedByteStream.h"
+
+#include <TParameter.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+ClassImp(ByteStreamFileReplayStage)
+
+ByteStreamFileReplayStage::ByteStreamFileReplayStage() = default;
+
+void ByteStreamFileReplayStage::OnInit() {
+    files_.clear();
+    if (parameters_.contains("files")) {
+        files_ = parameters_["files"].get<std::vector<std::string>>();
+    } else if (parameters_.contains("file")) {
+        files_.push_back(parameters_["file"].get<std::string>());
+    }
+    if (files_.empty()) {
+        spdlog::error("[{}] No \"files\" to replay", Name());
+    }
+
+    output_product_name_ = parameters_.value("output_product_name", "bytestream_bank_DATA");
+    reset_last_index_key_ = parameters_.value("reset_last_index_key", "");
+    bank_size_ = parameters_.value("bank_size_bytes", static_cast<size_t>(0));
+    prefetch_banks_ = parameters_.value("prefetch_banks", static_cast<size_t>(1));
+    release_consumed_ = parameters_.value("release_consumed", false);
+
+    has_packet_framing_ = false;
+    if (parameters_.contains("packet_framing")) {
+        has_packet_framing_ = PacketFraming::FromJson(parameters_["packet_framing"], packet_framing_);
+        if (!has_packet_framing_) {
+            spdlog::error("[{}] Invalid \"packet_framing\"; banks are cut at bank_size_bytes", Name());
+        }
+    }
+
+    next_file_ = 0;
+    file_.reset();
+    position_ = 0;
+    finished_ = false;
+
+    spdlog::debug("[{}] Replaying {} files into '{}', bank size {} bytes",
+                  Name(), files_.size(), output_product_name_, bank_size_);
+}
+
+void ByteStreamFileReplayStage::Process() {
+    if (finished_) {
+        return;
+    }
+
+    if ((!file_ || position_ >= file_->Size()) && !openNextFile()) {
+        finished_ = true;
+        file_.reset();
+        if (getDataProductManager()->hasProduct(output_product_name_)) {
+            getDataProductManager()->removeProduct(output_product_name_);
+        }
+        spdlog::info("[{}] Replay finished after {} files", Name(), files_.size());
+        return;
+    }
+
+    const size_t size = nextBankSize();
+    publishBank(size);
+    resetLastReadIndex();
+
+    // Pages of the bank before the previous one are no longer referenced by this event
+    if (release_consumed_ && previous_bank_start_ > released_up_to_) {
+        file_->Release(released_up_to_, previous_bank_start_ - released_up_to_);
+        released_up_to_ = previous_bank_start_;
+    }
+    previous_bank_start_ = position_;
+    position_ += size;
+
+    if (prefetch_banks_ > 0 && position_ < file_->Size()) {
+        const size_t ahead = bank_size_ ? bank_size_ * prefetch_banks_ : file_->Size();
+        file_->Prefetch(position_, ahead);
+    }
+}
+
+bool ByteStreamFileReplayStage::openNextFile() {
+    while (next_file_ < files_.size()) {
+        const std::string& path = files_[next_file_++];
+        auto file = MappedFile::Open(path, true);
+        if (!file) {
+            continue;  // logged by MappedFile
+        }
+        if (file->Size() == 0) {
+            spdlog::warn("[{}] Skipping empty file '{}'", Name(), path);
+            continue;
+        }
+        file_ = std::move(file);
+        position_ = 0;
+        released_up_to_ = 0;
+        previous_bank_start_ = 0;
+        spdlog::debug("[{}] Mapped '{}' ({} bytes)", Name(), path, file_->Size());
+        return true;
+    }
+    return false;
+}
+
+size_t ByteStreamFileReplayStage::nextBankSize() {
+    const size_t remaining = file_->Size() - position_;
+    if (bank_size_ == 0 || remaining <= bank_size_) {
+        return remaining;
+    }
+    if (!has_packet_framing_) {
+        return bank_size_;
+    }
+
+    // End the bank after the last record that fits, so no record spans two events
+    scan_offsets_.clear();
+    scan_lengths_.clear();
+    const auto result = PacketScanner::Scan(file_->Data(), position_ + bank_size_, position_,
+                                            packet_framing_, scan_offsets_, scan_lengths_);
+    if (result.end_offset > position_) {
+        return result.end_offset - position_;
+    }
+
+    // A single record larger than the bank goes out on its own
+    const size_t length = packet_framing_.RecordLength(file_->Data() + position_, remaining);
+    if (length > 0 && length <= remaining) {
+        return length;
+    }
+    spdlog::warn("[{}] No complete record at offset {} of '{}'; publishing {} bytes unframed",
+                 Name(), position_, file_->Path(), bank_size_);
+    return bank_size_;
+}
+
+void ByteStreamFileReplayStage::publishBank(size_t size) {
+    auto product = std::make_unique<PipelineDataProduct>();
+    product->setName(output_product_name_);
+    product->setObject(std::make_unique<MappedByteStream>(file_, position_, size));
+    product->addTag("bytestream");
+    product->addTag("mapped");
+    product->addTag("built_by_bytestream_file_replay_stage");
+    getDataProductManager()->addOrUpdate(output_product_name_, std::move(product));
+}
+
+void ByteStreamFileReplayStage::resetLastReadIndex() {
+    if (reset_last_index_key_.empty() || !getDataProductManager()->hasProduct(reset_last_index_key_)) {
+        return;
+    }
+    auto lock = getDataProductManager()->checkoutWrite(reset_last_index_key_);
+    TObject* obj = lock.get()->getObject();
+    if (auto* param = dynamic_cast<TParameter<Long64_t>*>(obj)) {
+        param->SetVal(0);
+    } else if (auto* param = dynamic_cast<TParameter<int>*>(obj)) {
+        param->SetVal(0);
+    }
+}
@@ -2,13 +2,24 @@
 #include "analysis_pipeline/core/data/pipeline_data_product_manager.h"
 #include "analysis_pipeline/core/data/pipeline_data_product.h"
 #include "analysis_pipeline/unpacker_core/data_products/ByteStream.h"
+#include "analysis_pipeline/unpacker_core/data_products/MappedByteStream.h"
+#include "analysis_pipeline/unpacker_core/data_products/StageMetricsSummary.h"
+#include "analysis_pipeline/unpacker_core/utils/column_decoder.h"
 #include "analysis_pipeline/unpacker_core/utils/field_mapping_parser.h"
+#include "analysis_pipeline/unpacker_core/utils/mapping_cache.h"
+#include "analysis_pipeline/unpacker_core/utils/reflection_based_parser.h"
 
 #include <TParameter.h>
 #include <TClass.h>
 #include <TObject.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+
 ClassImp(ByteStreamProcessorStage)
 
 ByteStreamProcessorStage::ByteStreamProcessorStage() = default;
@@ -16,57 +27,280 @@ ByteStreamProcessorStage::ByteStreamProcessorStage() = default;
 void ByteStreamProcessorStage::OnInit() {
     last_index_product_name_ = parameters_.value("last_index_key", "last_processed_packet_index");
     input_byte_stream_product_name_ = parameters_.value("input_byte_stream_product_name", "bytestream_bank_DATA");
+    wide_index_product_ = parameters_.value("wide_last_index", true);
+
+    // Applies to this stage's decodes only
+    debug_bounds_checks_ = parameters_.value("debug_bounds_checks", false);
+
+    // Set before derived stages construct their ReflectionBasedParsers
+    if (parameters_.contains("mapping_cache_file")) {
+        MappingCache::Instance().SetFile(parameters_["mapping_cache_file"].get<std::string>());
+    }
+    cursor_loaded_ = false;
+    cursor_dirty_ = false;
 
     spdlog::debug("[{}] Using last_index_key='{}', input_byte_stream_product_name='{}'",
                   Name(), last_index_product_name_, input_byte_stream_product_name_);
+
+    decode_pool_.reset();
+    if (parameters_.contains("parallel_decode")) {
+        const auto& parallel = parameters_["parallel_decode"];
+        const size_t threads = parallel.value("threads", static_cast<size_t>(1));
+        parallel_min_chunk_ = std::max<size_t>(1, parallel.value("min_chunk_records", static_cast<size_t>(256)));
+        if (threads > 1) {
+            decode_pool_ = std::make_unique<WorkStealingPool>(threads);
+            spdlog::debug("[{}] Parallel record decoding with {} threads, min chunk {} records",
+                          Name(), threads, parallel_min_chunk_);
+        }
+    }
+
+    size_t ingest_slots = 2;
+    IngestRing::Policy ingest_policy = IngestRing::Policy::kGrow;
+    size_t ingest_timeout_ms = 100;
+    if (parameters_.contains("pipelined_ingestion")) {
+        const auto& ingestion = parameters_["pipelined_ingestion"];
+        ingest_slots = std::max<size_t>(1, ingestion.value("slots", ingest_slots));
+        ingest_timeout_ms = ingestion.value("block_timeout_ms", ingest_timeout_ms);
+        const std::string policy = ingestion.value("back_pressure", std::string("block"));
+        if (!IngestRing::ParsePolicy(policy, ingest_policy)) {
+            spdlog::error("[{}] Unknown back_pressure '{}' in \"pipelined_ingestion\"; using \"block\"", Name(), policy);
+            ingest_policy = IngestRing::Policy::kBlock;
+        }
+        spdlog::debug("[{}] Pipelined ingestion with {} slots, back-pressure '{}'", Name(), ingest_slots, policy);
+    }
+    ingest_ring_ = IngestRing::Create(ingest_slots, ingest_policy, std::chrono::milliseconds(ingest_timeout_ms));
+
+    has_dispatch_table_ = false;
+    if (parameters_.contains("record_dispatch")) {
+        has_dispatch_table_ = RecordDispatchTable::FromJson(parameters_["record_dispatch"], dispatch_table_);
+        if (!has_dispatch_table_) {
+            spdlog::error("[{}] Invalid \"record_dispatch\"; dispatchRecords() is disabled", Name());
+        } else {
+            spdlog::debug("[{}] Dispatching {} record types", Name(), dispatch_table_.GetTypes().size());
+        }
+    }
+
+    selection_expression_ = parameters_.value("selection", std::string());
+    selections_.clear();
+    if (!selection_expression_.empty()) {
+        spdlog::debug("[{}] Selecting records with '{}'", Name(), selection_expression_);
+    }
+
+    has_checksum_ = false;
+    drop_bad_checksums_ = true;
+    checksum_failure_count_ = 0;
+    if (parameters_.contains("checksum")) {
+        const auto& checksum = parameters_["checksum"];
+        has_checksum_ = PacketChecksum::FromJson(checksum, checksum_);
+        drop_bad_checksums_ = checksum.value("on_failure", std::string("drop")) != "keep";
+        if (!has_checksum_) {
+            spdlog::error("[{}] Invalid \"checksum\"; records are not verified", Name());
+        } else {
+            spdlog::debug("[{}] Verifying record checksums (sum kernel '{}', crc32c kernel '{}'), {} bad records",
+                          Name(), Checksum::ActiveSumKernelName(), Checksum::ActiveCrc32cKernelName(),
+                          drop_bad_checksums_ ? "dropping" : "keeping");
+        }
+    }
+
+    has_packet_framing_ = false;
+    packet_index_product_name_ = parameters_.value("packet_index_product_name", input_byte_stream_product_name_ + "_index");
+    if (parameters_.contains("packet_framing")) {
+        has_packet_framing_ = PacketFraming::FromJson(parameters_["packet_framing"], packet_framing_);
+        if (!has_packet_framing_) {
+            spdlog::error("[{}] Invalid \"packet_framing\"; packet indexing is disabled", Name());
+        }
+    }
+
+    record_carry_.Clear();
+    record_carry_.SetMaxRecordBytes(parameters_.value("max_carried_record_bytes", record_carry_.GetMaxRecordBytes()));
+
+    metrics_product_name_.clear();
+    events_since_publish_ = 0;
+    if (parameters_.contains("metrics")) {
+        const auto& metrics = parameters_["metrics"];
+        metrics_product_name_ = metrics.value("product_name", Name() + "_metrics");
+        metrics_publish_every_ = std::max<size_t>(1, metrics.value("publish_every_events", static_cast<size_t>(1)));
+        if (!StageMetrics::kEnabled) {
+            spdlog::warn("[{}] Stage metrics requested, but the library was built without them", Name());
+            metrics_product_name_.clear();
+        } else {
+            spdlog::debug("[{}] Publishing stage metrics to '{}' every {} events",
+                          Name(), metrics_product_name_, metrics_publish_every_);
+        }
+    }
 }
 
 void ByteStreamProcessorStage::Process() {
     spdlog::warn("[{}] Base class Process() called. Override this method in your derived stage.", Name());
 }
 
-int ByteStreamProcessorStage::getLastReadIndex() const {
+int64_t ByteStreamProcessorStage::getLastReadIndex() const {
+    if (!cache_cursor_) {
+        return readLastReadIndexProduct();
+    }
+    if (!cursor_loaded_) {
+        cursor_ = readLastReadIndexProduct();
+        cursor_loaded_ = true;
+    }
+    return cursor_;
+}
+
+void ByteStreamProcessorStage::setLastReadIndex(int64_t index) {
+    if (!cache_cursor_) {
+        writeLastReadIndexProduct(index);
+        return;
+    }
+    cursor_ = index;
+    cursor_loaded_ = true;
+    cursor_dirty_ = true;
+}
+
+void ByteStreamProcessorStage::syncLastReadIndex() {
+    // A failed write stays pending, so the cursor is not reloaded from a stale product
+    if (cursor_dirty_ && writeLastReadIndexProduct(cursor_)) {
+        cursor_dirty_ = false;
+    }
+}
+
+int64_t ByteStreamProcessorStage::readLastReadIndexProduct() const {
     if (!getDataProductManager()->hasProduct(last_index_product_name_)) {
         return 0;
     }
 
     auto lock = getDataProductManager()->checkoutRead(last_index_product_name_);
-    auto* param = dynamic_cast<TParameter<int>*>(lock.get()->getObject());
-    if (param) {
+    TObject* obj = lock.get()->getObject();
+    if (auto* param = dynamic_cast<TParameter<Long64_t>*>(obj)) {
+        return param->GetVal();
+    }
+    if (auto* param = dynamic_cast<TParameter<int>*>(obj)) {
         return param->GetVal();
     }
 
-    spdlog::warn("[{}] Product '{}' exists but is not a TParameter<int>", Name(), last_index_product_name_);
+    spdlog::warn("[{}] Product '{}' exists but is not a TParameter<int> or TParameter<Long64_t>",
+                 Name(), last_index_product_name_);
     return 0;
 }
 
-
-void ByteStreamProcessorStage::setLastReadIndex(int index) {
-
+bool ByteStreamProcessorStage::writeLastReadIndexProduct(int64_t index) {
+    const bool fits_int = index >= std::numeric_limits<int>::min() && index <= std::numeric_limits<int>::max();
     if (!getDataProductManager()->hasProduct(last_index_product_name_)) {
-        createLastReadIndexProduct(index);
-        return;
+        return createLastReadIndexProduct(index, wide_index_product_ || !fits_int);
     }
 
-    auto lock = getDataProductManager()->checkoutWrite(last_index_product_name_);
-    auto* param = dynamic_cast<TParameter<int>*>(lock.get()->getObject());
-    if (param) {
-        param->SetVal(index);
-    } else {
-        spdlog::warn("[{}] Product '{}' exists but is not a TParameter<int>", Name(), last_index_product_name_);
+    {
+        auto lock = getDataProductManager()->checkoutWrite(last_index_product_name_);
+        TObject* obj = lock.get()->getObject();
+        if (auto* param = dynamic_cast<TParameter<Long64_t>*>(obj)) {
+            param->SetVal(index);
+            return true;
+        }
+        auto* param = dynamic_cast<TParameter<int>*>(obj);
+        if (!param) {
+            spdlog::warn("[{}] Product '{}' exists but is not a TParameter<int> or TParameter<Long64_t>",
+                         Name(), last_index_product_name_);
+            return false;
+        }
+        if (fits_int) {
+            param->SetVal(static_cast<int>(index));
+            return true;
+        }
     }
-}
 
+    // Replaced outside the write lock; readers accept either type
+    spdlog::info("[{}] Index {} exceeds TParameter<int>; promoting '{}' to TParameter<Long64_t>",
+                 Name(), index, last_index_product_name_);
+    return createLastReadIndexProduct(index, true);
+}
 
-void ByteStreamProcessorStage::createLastReadIndexProduct(int index) {
-    auto param = std::make_unique<TParameter<int>>(last_index_product_name_.c_str(), index);
+bool ByteStreamProcessorStage::createLastReadIndexProduct(int64_t index, bool wide) {
     auto product = std::make_unique<PipelineDataProduct>();
     product->setName(last_index_product_name_);
-    product->setObject(std::move(param));
+    if (wide) {
+        product->setObject(std::make_unique<TParameter<Long64_t>>(last_index_product_name_.c_str(), index));
+    } else {
+        product->setObject(std::make_unique<TParameter<int>>(last_index_product_name_.c_str(), static_cast<int>(index)));
+    }
     product->addTag("internal");
     product->addTag("byte_stream_index");
     product->addTag("built_by_bytestream_processor_stage");
     getDataProductManager()->addOrUpdate(last_index_product_name_, std::move(product));
+    return true;
+}
+
+bool ByteStreamProcessorStage::buildPacketIndex(
+    PacketIndex& index,
+    const uint8_t* data,
+    size_t data_size,
+    size_t start_offset) const
+{
+    if (!has_packet_framing_) {
+        spdlog::error("[{}] No \"packet_framing\" configured for a packet index", Name());
+        return false;
+    }
+
+    if (!data) {
+        spdlog::error("[{}] Null data pointer passed to buildPacketIndex", Name());
+        return false;
+    }
+
+    index.Build(data, data_size, start_offset, packet_framing_);
+    if (index.GetSkippedBytes() > 0) {
+        spdlog::warn("[{}] Skipped {} bytes of unframed data while indexing '{}'",
+                     Name(), index.GetSkippedBytes(), input_byte_stream_product_name_);
+    }
+    return true;
+}
+
+void ByteStreamProcessorStage::publishPacketIndex(std::unique_ptr<PacketIndex> index) {
+    auto product = std::make_unique<PipelineDataProduct>();
+    product->setName(packet_index_product_name_);
+    product->setObject(std::move(index));
+    product->addTag("internal");
+    product->addTag("packet_index");
+    product->addTag("built_by_bytestream_processor_stage");
+    getDataProductManager()->addOrUpdate(packet_index_product_name_, std::move(product));
+}
+
+void ByteStreamProcessorStage::endEvent() {
+    // From here on the cursor lives in the stage between event boundaries. Other stages may
+    // move it between events, so it is read from the product again next event unless the
+    // write-back failed and the product is known to be stale.
+    cache_cursor_ = true;
+    syncLastReadIndex();
+    cursor_loaded_ = cursor_dirty_;
+
+    if (metrics_product_name_.empty()) {
+        return;
+    }
+
+    if (++events_since_publish_ >= metrics_publish_every_) {
+        publishMetrics();
+    }
+}
+
+void ByteStreamProcessorStage::publishMetrics() {
+    StageMetrics::Totals totals;
+    metrics_.Collect(totals);
+
+    auto summary = std::make_unique<StageMetricsSummary>(Name());
+    summary->Add(totals, events_since_publish_);
+    events_since_publish_ = 0;
+
+    auto product = std::make_unique<PipelineDataProduct>();
+    product->setName(metrics_product_name_);
+    product->setObject(std::move(summary));
+    product->addTag("internal");
+    product->addTag("stage_metrics");
+    product->addTag("built_by_bytestream_processor_stage");
+    getDataProductManager()->addOrUpdate(metrics_product_name_, std::move(product));
+}
+
+void ByteStreamProcessorStage::recordDecodeFailure(const CompiledParsePlan& plan, const std::string* field) {
+    if (!StageMetrics::kEnabled) {
+        return;
+    }
+    metrics_.Add(StageMetrics::kDecodeFailures, 1);
+    metrics_.AddFieldFailure(std::string(plan.GetClass()->GetName()) + "." + (field ? *field : "<record>"));
 }
 
 PipelineDataProductReadLock ByteStreamProcessorStage::getInputByteStreamLock() const {
@@ -76,6 +310,7 @@ PipelineDataProductReadLock ByteStreamProcessorStage::getInputByteStreamLock() c
     }
 
     try {
+        StageMetrics::ScopedTimer wait(metrics_, StageMetrics::kLockWaitNs);
         return getDataProductManager()->checkoutRead(input_byte_stream_product_name_);
     } catch (const std::exception& e) {
         spdlog::error("[{}] Failed to checkout ByteStream product '{}': {}", Name(), input_byte_stream_product_name_, e.what());
@@ -83,6 +318,66 @@ PipelineDataProductReadLock ByteStreamProcessorStage::getInputByteStreamLock() c
     }
 }
 
+bool ByteStreamProcessorStage::getMappedInputBytes(const PipelineDataProductReadLock& lock,
+                                                   const uint8_t*& data,
+                                                   size_t& data_size) const {
+    if (!lock.get()) {
+        return false;
+    }
+    auto* mapped = dynamic_cast<const MappedByteStream*>(lock.get()->getObject());
+    if (!mapped) {
+        return false;
+    }
+    data = mapped->GetData();
+    data_size = mapped->GetSize();
+    return true;
+}
+
+IngestRing::Bank ByteStreamProcessorStage::acquireInputBank(const InputBytesFn& bytes_of) {
+    if (!ingest_ring_) {
+        spdlog::error("[{}] acquireInputBank() called before OnInit()", Name());
+        return IngestRing::Bank();
+    }
+
+    if (!getDataProductManager()->hasProduct(input_byte_stream_product_name_)) {
+        spdlog::debug("[{}] Input ByteStream product '{}' not found", Name(), input_byte_stream_product_name_);
+        return IngestRing::Bank();
+    }
+
+    // The slot is taken before the read lock, so a back-pressure wait never holds up the
+    // producer; the lock then only covers the copy. Mapped banks need no slot, and an
+    // unused reservation goes straight back to the ring.
+    IngestRing::Reservation slot = ingest_ring_->Reserve();
+
+    auto lock = getInputByteStreamLock();
+    if (!lock.get()) {
+        return IngestRing::Bank();
+    }
+    const TObject* product = lock.get()->getObject();
+    if (auto* mapped = dynamic_cast<const MappedByteStream*>(product)) {
+        if (!mapped->GetFile()) {
+            spdlog::error("[{}] Mapped input product '{}' has no file", Name(), input_byte_stream_product_name_);
+            return IngestRing::Bank();
+        }
+        return ingest_ring_->Share(mapped->GetFile(), mapped->GetData(), mapped->GetSize());
+    }
+
+    if (!slot) {
+        spdlog::warn("[{}] All {} ingestion slots are in use; dropped a bank ({} so far) of '{}'",
+                     Name(), ingest_ring_->GetSlotCount(), ingest_ring_->GetDroppedCount(),
+                     input_byte_stream_product_name_);
+        return IngestRing::Bank();
+    }
+
+    const uint8_t* data = nullptr;
+    size_t data_size = 0;
+    if (!product || !bytes_of || !bytes_of(*product, data, data_size)) {
+        spdlog::error("[{}] Cannot read the bytes of input product '{}'", Name(), input_byte_stream_product_name_);
+        return IngestRing::Bank();
+    }
+    return ingest_ring_->Fill(std::move(slot), data, data_size);
+}
+
 std::unique_ptr<TObject> ByteStreamProcessorStage::parseObjectFromBytes(
     TObject* obj,
     const uint8_t* data,
@@ -90,6 +385,25 @@ std::unique_ptr<TObject> ByteStreamProcessorStage::parseObjectFromBytes(
     const nlohmann::json& field_mapping_json,
     size_t start_offset)
 {
+    if (!obj) {
+        spdlog::error("[{}] Null TObject pointer passed to parseObjectFromBytes", Name());
+        return nullptr;
+    }
+    return parseObjectFromBytes(obj, data, data_size, getPlan(obj->IsA(), field_mapping_json), start_offset);
+}
+
+std::unique_ptr<TObject> ByteStreamProcessorStage::parseObjectFromBytes(
+    TObject* obj,
+    const uint8_t* data,
+    size_t data_size,
+    const std::shared_ptr<const CompiledParsePlan>& plan,
+    size_t start_offset)
+{
+    if (!plan) {
+        delete obj;
+        return nullptr;
+    }
+
     if (!data) {
         spdlog::error("[{}] Null data pointer passed to parseObjectFromBytes", Name());
         return nullptr;
@@ -105,9 +419,7 @@ std::unique_ptr<TObject> ByteStreamProcessorStage::parseObjectFromBytes(
         return nullptr;
     }
 
-    bool success = field_mapping_parser_.ParseAndFill(data, data_size, start_offset, field_mapping_json, obj);
-    if (!success) {
-        spdlog::error("[{}] FieldMappingParser failed to fill object '{}'", Name(), obj->ClassName());
+    if (!decodeObject(obj, data, data_size, *plan, start_offset)) {
         delete obj;
         return nullptr;
     }
@@ -115,4 +427,871 @@ std::unique_ptr<TObject> ByteStreamProcessorStage::parseObjectFromBytes(
     return std::unique_ptr<TObject>(obj);
 }
 
+std::shared_ptr<const CompiledParsePlan> ByteStreamProcessorStage::getPlan(
+    TClass* cls,
+    const nlohmann::json& field_mapping_json)
+{
+    auto plan = field_mapping_parser_.GetPlan(field_mapping_json, cls);
+    if (!plan) {
+        spdlog::error("[{}] Failed to compile field mapping for class '{}'", Name(), cls ? cls->GetName() : "<null>");
+    }
+    return plan;
+}
+
+bool ByteStreamProcessorStage::decodeObject(
+    TObject* obj,
+    const uint8_t* data,
+    size_t data_size,
+    const CompiledParsePlan& plan,
+    size_t start_offset)
+{
+    StageMetrics::ScopedTimer timer(metrics_, StageMetrics::kDecodeNs);
+    size_t record_size = 0;
+    if (!executePlan(plan, false, data, data_size, start_offset, obj, &record_size)) {
+        spdlog::error("[{}] FieldMappingParser failed to fill object '{}'", Name(), obj->ClassName());
+        recordDecodeFailure(plan, CompiledParsePlan::LastFailedField());
+        return false;
+    }
+
+    metrics_.Add(StageMetrics::kRecordsDecoded, 1);
+    metrics_.Add(StageMetrics::kBytesConsumed, record_size);
+    return true;
+}
+
+size_t ByteStreamProcessorStage::dispatchRecords(
+    const uint8_t* data,
+    size_t data_size,
+    size_t start_offset,
+    size_t* end_offset)
+{
+    if (end_offset) {
+        *end_offset = start_offset;
+    }
+    if (!has_dispatch_table_) {
+        spdlog::error("[{}] dispatchRecords() called without a valid \"record_dispatch\" parameter", Name());
+        return 0;
+    }
+    if (!data || start_offset > data_size) {
+        spdlog::error("[{}] Invalid buffer for dispatched records (start offset {}, size {})",
+                      Name(), start_offset, data_size);
+        return 0;
+    }
+
+    const auto& types = dispatch_table_.GetTypes();
+    std::vector<std::unique_ptr<TClonesArray>> arrays;
+    std::vector<TClonesArray*> outputs;
+    arrays.reserve(types.size());
+    outputs.reserve(types.size());
+    for (const auto& type : types) {
+        arrays.push_back(std::make_unique<TClonesArray>(type.cls));
+        outputs.push_back(arrays.back().get());
+    }
+
+    RecordDispatchTable::Result result;
+    {
+        StageMetrics::ScopedTimer timer(metrics_, StageMetrics::kDecodeNs);
+        result = dispatch_table_.Decode(data, data_size, start_offset, outputs, debug_bounds_checks_);
+    }
+
+    if (result.failed) {
+        spdlog::error("[{}] Failed to decode a '{}' record at offset {}",
+                      Name(), result.failed->cls->GetName(), result.end_offset);
+        recordDecodeFailure(*result.failed->plan, CompiledParsePlan::LastFailedField());
+    } else if (result.unknown_tag) {
+        spdlog::warn("[{}] Unknown record tag {} at offset {}", Name(),
+                     dispatch_table_.ReadTag(data + result.end_offset), result.end_offset);
+    }
+    if (result.skipped_records > 0) {
+        spdlog::debug("[{}] Skipped {} records with unknown tags", Name(), result.skipped_records);
+    }
+
+    for (size_t i = 0; i < types.size(); ++i) {
+        auto product = std::make_unique<PipelineDataProduct>();
+        product->setName(types[i].product_name);
+        product->setObject(std::move(arrays[i]));
+        product->addTag("dispatched_records");
+        product->addTag("built_by_bytestream_processor_stage");
+        getDataProductManager()->addOrUpdate(types[i].product_name, std::move(product));
+    }
+
+    metrics_.Add(StageMetrics::kRecordsDecoded, result.records);
+    metrics_.Add(StageMetrics::kBytesConsumed, result.end_offset - start_offset);
+    if (end_offset) {
+        *end_offset = result.end_offset;
+    }
+    return result.records;
+}
+
+const RecordPredicate* ByteStreamProcessorStage::getSelection(const std::shared_ptr<const CompiledParsePlan>& plan) {
+    if (selection_expression_.empty() || !plan) {
+        return nullptr;
+    }
+
+    auto it = selections_.find(plan.get());
+    if (it != selections_.end() && it->second.first.lock() == plan) {
+        return it->second.second.get();
+    }
+
+    // A failed compile is cached as well, so the error is logged once per plan
+    auto predicate = RecordPredicate::Compile(selection_expression_, *plan);
+    if (!predicate) {
+        spdlog::error("[{}] Selection '{}' does not apply to class '{}'; its records are not filtered",
+                      Name(), selection_expression_, plan->GetClass()->GetName());
+    }
+    auto& entry = selections_[plan.get()];
+    entry = {plan, std::move(predicate)};
+    return entry.second.get();
+}
+
+bool ByteStreamProcessorStage::passesSelection(const std::shared_ptr<const CompiledParsePlan>& plan,
+                                               const uint8_t* data,
+                                               size_t data_size,
+                                               size_t start_offset) {
+    const RecordPredicate* selection = getSelection(plan);
+    if (!selection || !data) {
+        return true;
+    }
+    if (!selection->Matches(data, data_size, start_offset)) {
+        metrics_.Add(StageMetrics::kRecordsRejected, 1);
+        return false;
+    }
+    metrics_.Add(StageMetrics::kRecordsAccepted, 1);
+    return true;
+}
+
+ObjectPool* ByteStreamProcessorStage::getObjectPool(TClass* cls) {
+    auto it = object_pools_.find(cls);
+    if (it != object_pools_.end()) {
+        return it->second.get();
+    }
+
+    auto pool = ObjectPool::Create(cls);
+    if (!pool) {
+        return nullptr;
+    }
+    return object_pools_.emplace(cls, std::move(pool)).first->second.get();
+}
+
+PooledObject ByteStreamProcessorStage::parsePooledObjectFromBytes(
+    TClass* cls,
+    const uint8_t* data,
+    size_t data_size,
+    const nlohmann::json& field_mapping_json,
+    size_t start_offset)
+{
+    if (!cls) {
+        spdlog::error("[{}] No object pool available for class '<null>'", Name());
+        return PooledObject();
+    }
+    return parsePooledObjectFromBytes(getPlan(cls, field_mapping_json), data, data_size, start_offset);
+}
+
+PooledObject ByteStreamProcessorStage::parsePooledObjectFromBytes(
+    const std::shared_ptr<const CompiledParsePlan>& plan,
+    const uint8_t* data,
+    size_t data_size,
+    size_t start_offset)
+{
+    if (!plan) {
+        return PooledObject();
+    }
+
+    TClass* cls = plan->GetClass();
+    ObjectPool* pool = getObjectPool(cls);
+    if (!pool) {
+        spdlog::error("[{}] No object pool available for class '{}'", Name(), cls ? cls->GetName() : "<null>");
+        return PooledObject();
+    }
+
+    if (!data) {
+        spdlog::error("[{}] Null data pointer passed to parsePooledObjectFromBytes", Name());
+        return PooledObject();
+    }
+
+    if (start_offset >= data_size) {
+        spdlog::error("[{}] Start offset {} >= data size {}", Name(), start_offset, data_size);
+        return PooledObject();
+    }
+
+    PooledObject obj = pool->Acquire();
+    if (!obj) {
+        return obj;
+    }
+
+    // On failure the object is recycled by PooledObject's deleter rather than freed
+    if (!decodeObject(obj.get(), data, data_size, *plan, start_offset)) {
+        return PooledObject();
+    }
+
+    return obj;
+}
+
+std::unique_ptr<TClonesArray> ByteStreamProcessorStage::parseRecordsFromBytes(
+    const std::string& class_name,
+    const uint8_t* data,
+    size_t data_size,
+    size_t stride,
+    size_t count,
+    const nlohmann::json& field_mapping_json,
+    size_t start_offset)
+{
+    TClass* cls = TClass::GetClass(class_name.c_str());
+    if (!cls || !cls->InheritsFrom(TObject::Class())) {
+        spdlog::error("[{}] Class '{}' not found or not a TObject", Name(), class_name);
+        return nullptr;
+    }
+
+    auto out = std::make_unique<TClonesArray>(cls, static_cast<Int_t>(count));
+    parseRecordsFromBytes(*out, data, data_size, stride, count, field_mapping_json, start_offset);
+    return out;
+}
+
+size_t ByteStreamProcessorStage::parseRecordsFromBytes(
+    TClonesArray& out,
+    const uint8_t* data,
+    size_t data_size,
+    size_t stride,
+    size_t count,
+    const nlohmann::json& field_mapping_json,
+    size_t start_offset,
+    size_t* consumed)
+{
+    out.Clear();
+    if (consumed) {
+        *consumed = 0;
+    }
+
+    TClass* cls = out.GetClass();
+    if (!cls) {
+        spdlog::error("[{}] Output TClonesArray has no class", Name());
+        return 0;
+    }
+
+    const auto plan = field_mapping_parser_.GetPlan(field_mapping_json, cls);
+    if (!plan) {
+        spdlog::error("[{}] Failed to compile field mapping for class '{}'", Name(), cls->GetName());
+        return 0;
+    }
+
+    return parseRecordsWithPlan(out, plan, data, data_size, stride, count, start_offset, consumed);
+}
+
+size_t ByteStreamProcessorStage::parseRecordsFromBytes(
+    TClonesArray& out,
+    const uint8_t* data,
+    size_t data_size,
+    size_t count,
+    const ReflectionBasedParser& parser,
+    size_t start_offset,
+    size_t* consumed)
+{
+    out.Clear();
+    if (consumed) {
+        *consumed = 0;
+    }
+
+    const auto& plan = parser.GetPlan();
+    if (out.GetClass() != plan->GetClass()) {
+        spdlog::error("[{}] Output TClonesArray class does not match parser class '{}'",
+                      Name(), plan->GetClass()->GetName());
+        return 0;
+    }
+
+    // Variable-length records are read back to back
+    const size_t stride = plan->HasVariableLength() ? 0 : parser.GetTotalParsedSize();
+    return parseRecordsWithPlan(out, plan, data, data_size, stride, count, start_offset, consumed);
+}
+
+std::unique_ptr<RecordViewCollection> ByteStreamProcessorStage::makeRecordViews(
+    const std::string& class_name,
+    const uint8_t* data,
+    size_t data_size,
+    size_t stride,
+    size_t count,
+    const nlohmann::json& field_mapping_json,
+    size_t start_offset,
+    std::shared_ptr<const void> owner)
+{
+    TClass* cls = TClass::GetClass(class_name.c_str());
+    if (!cls) {
+        spdlog::error("[{}] Class '{}' not found", Name(), class_name);
+        return nullptr;
+    }
+
+    const auto plan = field_mapping_parser_.GetPlan(field_mapping_json, cls);
+    if (!plan) {
+        spdlog::error("[{}] Failed to compile field mapping for class '{}'", Name(), class_name);
+        return nullptr;
+    }
+
+    return makeRecordViewsWithPlan(plan, data, data_size, stride, count, start_offset, std::move(owner));
+}
+
+std::unique_ptr<RecordViewCollection> ByteStreamProcessorStage::makeRecordViews(
+    const ReflectionBasedParser& parser,
+    const uint8_t* data,
+    size_t data_size,
+    size_t count,
+    size_t start_offset,
+    std::shared_ptr<const void> owner)
+{
+    if (parser.GetPlan()->HasVariableLength()) {
+        spdlog::error("[{}] Record views need a fixed stride, but class '{}' has variable-length fields",
+                      Name(), parser.GetPlan()->GetClass()->GetName());
+        return nullptr;
+    }
+
+    return makeRecordViewsWithPlan(parser.GetPlan(), data, data_size, parser.GetTotalParsedSize(), count,
+                                   start_offset, std::move(owner));
+}
+
+std::unique_ptr<RecordViewCollection> ByteStreamProcessorStage::makeRecordViewsWithPlan(
+    const std::shared_ptr<const CompiledParsePlan>& plan,
+    const uint8_t* data,
+    size_t data_size,
+    size_t stride,
+    size_t count,
+    size_t start_offset,
+    std::shared_ptr<const void> owner)
+{
+    if (count > 0 && !validateRecordRange(data, data_size, stride, count, start_offset)) {
+        return nullptr;
+    }
+
+    if (owner) {
+        auto views = std::make_unique<RecordViewCollection>(plan, std::move(owner), data, data_size);
+        views->AddRecords(start_offset, stride, count);
+        return views;
+    }
+
+    // Only the records' own bytes are copied, rebased to offset 0
+    size_t end = start_offset;
+    if (count > 0) {
+        end = std::min(data_size, start_offset + (count - 1) * stride + std::max(stride, plan->GetRecordExtent()));
+    }
+    auto views = std::make_unique<RecordViewCollection>(plan, count > 0 ? data + start_offset : nullptr,
+                                                        end - start_offset);
+    views->AddRecords(0, stride, count);
+    return views;
+}
+
+std::unique_ptr<ColumnarRecordBatch> ByteStreamProcessorStage::parseColumnsFromBytes(
+    const std::string& class_name,
+    const uint8_t* data,
+    size_t data_size,
+    size_t stride,
+    size_t count,
+    const nlohmann::json& field_mapping_json,
+    size_t start_offset)
+{
+    TClass* cls = TClass::GetClass(class_name.c_str());
+    if (!cls) {
+        spdlog::error("[{}] Class '{}' not found", Name(), class_name);
+        return nullptr;
+    }
+
+    auto out = std::make_unique<ColumnarRecordBatch>();
+    if (count > 0 && parseColumnsFromBytes(*out, cls, data, data_size, stride, count, field_mapping_json, start_offset) == 0) {
+        return nullptr;
+    }
+    return out;
+}
+
+size_t ByteStreamProcessorStage::parseColumnsFromBytes(
+    ColumnarRecordBatch& out,
+    TClass* cls,
+    const uint8_t* data,
+    size_t data_size,
+    size_t stride,
+    size_t count,
+    const nlohmann::json& field_mapping_json,
+    size_t start_offset)
+{
+    out.Clear();
+
+    const auto plan = field_mapping_parser_.GetPlan(field_mapping_json, cls);
+    if (!plan) {
+        spdlog::error("[{}] Failed to compile field mapping for class '{}'", Name(), cls ? cls->GetName() : "<null>");
+        return 0;
+    }
+
+    for (const auto& field : plan->GetFields()) {
+        if (!ColumnDecoder::Supports(field)) {
+            spdlog::error("[{}] Field '{}' of class '{}' has no columnar layout", Name(), field.name, cls->GetName());
+            return 0;
+        }
+    }
+
+    if (count == 0 || !validateRecordRange(data, data_size, stride, count, start_offset)) {
+        return 0;
+    }
+
+    // Columns are decoded without per-record checks, so the whole batch is checked up front:
+    // the last record's fields and every end-relative field must lie inside the buffer
+    const size_t last_start = start_offset + (count - 1) * stride;
+    if (!plan->CheckRange(data_size, start_offset, last_start)) {
+        spdlog::error("[{}] Records at offsets {}..{} ({} bytes each) or end-relative fields exceed data size {}",
+                      Name(), start_offset, last_start, plan->GetRecordExtent(), data_size);
+        return 0;
+    }
+
+    StageMetrics::ScopedTimer timer(metrics_, StageMetrics::kDecodeNs);
+    out.Reset(plan, count);
+
+    const auto& fields = plan->GetFields();
+    auto decode_range = [&](size_t begin, size_t end) {
+        for (size_t f = 0; f < fields.size(); ++f) {
+            ColumnDecoder::Decode(fields[f], data, data_size, start_offset, stride, begin, end - begin,
+                                  out.GetColumnData(f));
+        }
+    };
+
+    // Each worker fills a disjoint record range of every column
+    if (decode_pool_ && count >= 2 * parallel_min_chunk_) {
+        decode_pool_->ParallelFor(count, parallel_min_chunk_, decode_range);
+    } else {
+        decode_range(0, count);
+    }
+
+    metrics_.Add(StageMetrics::kRecordsDecoded, count);
+    metrics_.Add(StageMetrics::kBytesConsumed, count * stride);
+    return count;
+}
+
+bool ByteStreamProcessorStage::validateRecordRange(
+    const uint8_t* data,
+    size_t data_size,
+    size_t stride,
+    size_t count,
+    size_t start_offset) const
+{
+    if (!data) {
+        spdlog::error("[{}] Null data pointer passed for a record batch", Name());
+        return false;
+    }
+
+    if (stride == 0) {
+        spdlog::error("[{}] Zero record stride passed for a record batch", Name());
+        return false;
+    }
+
+    if (start_offset >= data_size || (count - 1) > (data_size - start_offset - 1) / stride) {
+        spdlog::error("[{}] {} records of stride {} from offset {} exceed data size {}",
+                      Name(), count, stride, start_offset, data_size);
+        return false;
+    }
+
+    return true;
+}
 
+size_t ByteStreamProcessorStage::parseRecordsWithPlan(
+    TClonesArray& out,
+    const std::shared_ptr<const CompiledParsePlan>& plan,
+    const uint8_t* data,
+    size_t data_size,
+    size_t stride,
+    size_t count,
+    size_t start_offset,
+    size_t* consumed)
+{
+    if (stride == 0 && plan->HasVariableLength()) {
+        // No checksum or selection on this path, so every decoded record is kept
+        const size_t decoded = parseConsecutiveRecords(out, *plan, data, data_size, count, start_offset);
+        if (consumed) {
+            *consumed = decoded;
+        }
+        return decoded;
+    }
+
+    if (count == 0 || !validateRecordRange(data, data_size, stride, count, start_offset)) {
+        return 0;
+    }
+
+    // The batch is bounds-checked once here; if any record is out of range, every record is
+    // checked so the output still ends at the first bad one
+    const bool trusted = out.GetClass() == plan->GetClass() &&
+                         plan->CheckRange(data_size, start_offset, start_offset + (count - 1) * stride);
+    size_t read = 0;
+    const size_t kept = decodeRecords(out, *plan, data, data_size, count, trusted, getSelection(plan),
+                                      [start_offset, stride](size_t i) { return start_offset + i * stride; },
+                                      [stride](size_t) { return stride; }, read);
+    metrics_.Add(StageMetrics::kBytesConsumed, read * stride);
+    if (consumed) {
+        *consumed = read;
+    }
+    return kept;
+}
+
+size_t ByteStreamProcessorStage::parseIndexedRecords(
+    TClonesArray& out,
+    const PacketIndex& index,
+    size_t first,
+    size_t count,
+    const uint8_t* data,
+    size_t data_size,
+    const nlohmann::json& field_mapping_json,
+    size_t* consumed)
+{
+    out.Clear();
+    if (consumed) {
+        *consumed = 0;
+    }
+
+    TClass* cls = out.GetClass();
+    if (!cls) {
+        spdlog::error("[{}] Output TClonesArray has no class", Name());
+        return 0;
+    }
+
+    if (!data) {
+        spdlog::error("[{}] Null data pointer passed for indexed records", Name());
+        return 0;
+    }
+
+    if (first > index.GetEntries() || count > index.GetEntries() - first) {
+        spdlog::error("[{}] Records {}..{} requested from a packet index of {} records",
+                      Name(), first, first + count, index.GetEntries());
+        return 0;
+    }
+
+    const auto plan = field_mapping_parser_.GetPlan(field_mapping_json, cls);
+    if (!plan) {
+        spdlog::error("[{}] Failed to compile field mapping for class '{}'", Name(), cls->GetName());
+        return 0;
+    }
+
+    // Offsets ascend, so checking the first and last record covers the batch; an index built
+    // over a different buffer fails the check and every record is then checked on its own
+    const uint64_t* offsets = index.GetOffsets().data() + first;
+    const uint32_t* lengths = index.GetLengths().data() + first;
+    const bool trusted = count > 0 && plan->CheckRange(data_size, offsets[0], offsets[count - 1]);
+    size_t read = 0;
+    const size_t kept = decodeRecords(out, *plan, data, data_size, count, trusted, getSelection(plan),
+                                      [offsets](size_t i) { return static_cast<size_t>(offsets[i]); },
+                                      [lengths](size_t i) { return static_cast<size_t>(lengths[i]); }, read);
+
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < read; ++i) {
+        bytes += index.GetLength(first + i);
+    }
+    metrics_.Add(StageMetrics::kBytesConsumed, bytes);
+    if (consumed) {
+        *consumed = read;
+    }
+    return kept;
+}
+
+size_t ByteStreamProcessorStage::parseStreamRecords(
+    TClonesArray& out,
+    const uint8_t* data,
+    size_t data_size,
+    const nlohmann::json& field_mapping_json,
+    size_t start_offset,
+    size_t* end_offset)
+{
+    out.Clear();
+    if (end_offset) {
+        *end_offset = start_offset;
+    }
+
+    TClass* cls = out.GetClass();
+    if (!cls) {
+        spdlog::error("[{}] Output TClonesArray has no class", Name());
+        return 0;
+    }
+
+    if (!has_packet_framing_) {
+        spdlog::error("[{}] parseStreamRecords() called without a valid \"packet_framing\" parameter", Name());
+        return 0;
+    }
+
+    if (!data || start_offset > data_size) {
+        spdlog::error("[{}] Invalid buffer for stream records (start offset {}, size {})",
+                      Name(), start_offset, data_size);
+        return 0;
+    }
+
+    const auto plan = field_mapping_parser_.GetPlan(field_mapping_json, cls);
+    if (!plan) {
+        spdlog::error("[{}] Failed to compile field mapping for class '{}'", Name(), cls->GetName());
+        return 0;
+    }
+    const RecordPredicate* selection = getSelection(plan);
+
+    // Finish the record the previous bank ended in. Only its own bytes are copied; the
+    // rest of this bank is decoded where it lies.
+    size_t pos = start_offset;
+    if (record_carry_.Pending()) {
+        const size_t carried = record_carry_.Size();
+        size_t taken = 0;
+        const auto status = record_carry_.Complete(
+            data + start_offset, data_size - start_offset, packet_framing_.HeaderSize(),
+            [this](const uint8_t* record) { return packet_framing_.HeaderLength(record); }, taken);
+        pos += taken;
+
+        if (status == RecordCarry::Status::kIncomplete) {
+            // The whole bank belongs to the carried record
+            metrics_.Add(StageMetrics::kBytesConsumed, taken);
+            if (end_offset) {
+                *end_offset = data_size;
+            }
+            return 0;
+        }
+        if (status == RecordCarry::Status::kMalformed) {
+            spdlog::warn("[{}] Dropped {} carried bytes that do not frame a record across the bank boundary",
+                         Name(), carried);
+        } else {
+            const uint8_t* record = record_carry_.Data();
+            const size_t length = record_carry_.Size();
+            size_t read = 0;
+            decodeRecords(out, *plan, record, length, 1, false, selection,
+                          [](size_t) { return static_cast<size_t>(0); },
+                          [length](size_t) { return length; }, read);
+            if (read == 0) {
+                spdlog::warn("[{}] Dropped a record stitched across the bank boundary", Name());
+            }
+            metrics_.Add(StageMetrics::kRecordsCarried, 1);
+            metrics_.Add(StageMetrics::kBytesConsumed, taken);
+            record_carry_.Clear();
+        }
+    }
+
+    stream_offsets_.clear();
+    stream_lengths_.clear();
+    const auto scan = PacketScanner::Scan(data, data_size, pos, packet_framing_, stream_offsets_, stream_lengths_);
+    if (scan.skipped_bytes > 0) {
+        spdlog::warn("[{}] Skipped {} bytes of unframed data in '{}'",
+                     Name(), scan.skipped_bytes, input_byte_stream_product_name_);
+    }
+
+    // Offsets ascend, so the first and last record bound the batch as in parseIndexedRecords
+    const size_t count = stream_offsets_.size();
+    const uint64_t* offsets = stream_offsets_.data();
+    const uint32_t* lengths = stream_lengths_.data();
+    size_t decoded = 0;
+    if (count > 0) {
+        const bool trusted = plan->CheckRange(data_size, offsets[0], offsets[count - 1]);
+        decodeRecords(out, *plan, data, data_size, count, trusted, selection,
+                      [offsets](size_t i) { return static_cast<size_t>(offsets[i]); },
+                      [lengths](size_t i) { return static_cast<size_t>(lengths[i]); }, decoded);
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < decoded; ++i) {
+            bytes += lengths[i];
+        }
+        metrics_.Add(StageMetrics::kBytesConsumed, bytes);
+    }
+
+    size_t end = scan.end_offset;
+    if (decoded < count) {
+        end = static_cast<size_t>(offsets[decoded]);
+    } else if (end < data_size) {
+        if (packet_framing_.IsTruncatedRecord(data + end, data_size - end) &&
+            record_carry_.Stash(data, data_size, end)) {
+            metrics_.Add(StageMetrics::kBytesConsumed, data_size - end);
+            end = data_size;
+        } else {
+            spdlog::warn("[{}] {} trailing bytes at offset {} do not start a record that fits the carry buffer",
+                         Name(), data_size - end, end);
+        }
+    }
+
+    if (end_offset) {
+        *end_offset = end;
+    }
+    return static_cast<size_t>(out.GetEntriesFast());
+}
+
+template<typename OffsetFn, typename LengthFn>
+size_t ByteStreamProcessorStage::decodeRecords(
+    TClonesArray& out,
+    const CompiledParsePlan& plan,
+    const uint8_t* data,
+    size_t data_size,
+    size_t count,
+    bool trusted,
+    const RecordPredicate* selection,
+    OffsetFn offset_of,
+    LengthFn length_of,
+    size_t& consumed)
+{
+    StageMetrics::ScopedTimer timer(metrics_, StageMetrics::kDecodeNs);
+    const Int_t base = out.GetEntriesFast();
+
+    // The checksum is verified right before the record is decoded, while its bytes are in
+    // cache, instead of in a separate pass over the bank. The selection then reads only the
+    // fields it needs, so rejected records are never decoded.
+    const bool verify = has_checksum_;
+    const bool skips = (verify && drop_bad_checksums_) || selection;
+    std::atomic<size_t> bad_checksums{0};
+    auto keep = [&](size_t i) {
+        const size_t offset = offset_of(i);
+        if (verify) {
+            const size_t length = length_of(i);
+            if (offset > data_size || length > data_size - offset || !checksum_.Verify(data + offset, length)) {
+                bad_checksums.fetch_add(1, std::memory_order_relaxed);
+                metrics_.Add(StageMetrics::kChecksumFailures, 1);
+                if (drop_bad_checksums_) {
+                    return false;
+                }
+            }
+        }
+        if (selection && !selection->Matches(data, data_size, offset)) {
+            metrics_.Add(StageMetrics::kRecordsRejected, 1);
+            return false;
+        }
+        return true;
+    };
+
+    if (!decode_pool_ || count < 2 * parallel_min_chunk_) {
+        size_t filled = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (skips && !keep(i)) {
+                continue;
+            }
+            const Int_t idx = base + static_cast<Int_t>(filled);
+            TObject* obj = out.ConstructedAt(idx, "C");
+            const bool ok = executePlan(plan, trusted, data, data_size, offset_of(i), obj);
+            if (!ok) {
+                spdlog::error("[{}] Failed to decode record {} of {} for class '{}'",
+                              Name(), i, count, plan.GetClass()->GetName());
+                recordDecodeFailure(plan, CompiledParsePlan::LastFailedField());
+                out.RemoveAt(idx);
+                metrics_.Add(StageMetrics::kRecordsDecoded, filled);
+                if (selection) {
+                    metrics_.Add(StageMetrics::kRecordsAccepted, filled);
+                }
+                reportChecksumFailures(bad_checksums.load(), i + 1);
+                consumed = i;
+                return filled;
+            }
+            ++filled;
+        }
+        metrics_.Add(StageMetrics::kRecordsDecoded, filled);
+        if (selection) {
+            metrics_.Add(StageMetrics::kRecordsAccepted, filled);
+        }
+        reportChecksumFailures(bad_checksums.load(), count);
+        consumed = count;
+        return filled;
+    }
+
+    // Checksums and the selection are settled first, so only kept records get an object
+    if (skips) {
+        record_skipped_.assign(count, 0);
+        decode_pool_->ParallelFor(count, parallel_min_chunk_, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                record_skipped_[i] = !keep(i);
+            }
+        });
+        kept_records_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (!record_skipped_[i]) {
+                kept_records_.push_back(i);
+            }
+        }
+    }
+    const size_t kept = skips ? kept_records_.size() : count;
+    auto record_of = [&](size_t k) { return skips ? kept_records_[k] : k; };
+
+    // TClonesArray is not thread-safe, so objects are constructed up front and the workers
+    // only fill disjoint index ranges of them
+    decode_targets_.resize(kept);
+    for (size_t k = 0; k < kept; ++k) {
+        decode_targets_[k] = out.ConstructedAt(base + static_cast<Int_t>(k), "C");
+    }
+
+    // Like the serial path, the result ends at the first malformed record. Records below the
+    // lowest failing one are always decoded, so the output does not depend on scheduling.
+    std::atomic<size_t> first_failure{kept};     // position in the kept records
+    std::mutex failure_mutex;
+    size_t failed_record = kept;                 // guarded by failure_mutex
+    const std::string* failed_field = nullptr;   // field that failed failed_record
+    decode_pool_->ParallelFor(kept, parallel_min_chunk_, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            if (k >= first_failure.load(std::memory_order_relaxed)) {
+                return;
+            }
+            const bool ok = executePlan(plan, trusted, data, data_size, offset_of(record_of(k)), decode_targets_[k]);
+            if (!ok) {
+                size_t current = first_failure.load(std::memory_order_relaxed);
+                while (k < current && !first_failure.compare_exchange_weak(current, k)) {
+                }
+                std::lock_guard<std::mutex> lock(failure_mutex);
+                if (k < failed_record) {
+                    failed_record = k;
+                    failed_field = CompiledParsePlan::LastFailedField();
+                }
+                return;
+            }
+        }
+    });
+
+    const size_t filled = first_failure.load();
+    consumed = count;
+    if (filled < kept) {
+        consumed = record_of(filled);
+        spdlog::error("[{}] Failed to decode record {} of {} for class '{}'",
+                      Name(), consumed, count, plan.GetClass()->GetName());
+        recordDecodeFailure(plan, failed_field);
+        for (size_t k = kept; k-- > filled;) {
+            out.RemoveAt(base + static_cast<Int_t>(k));
+        }
+    }
+
+    metrics_.Add(StageMetrics::kRecordsDecoded, filled);
+    if (selection) {
+        metrics_.Add(StageMetrics::kRecordsAccepted, filled);
+    }
+    reportChecksumFailures(bad_checksums.load(), count);
+    return filled;
+}
+
+void ByteStreamProcessorStage::reportChecksumFailures(size_t failures, size_t checked) {
+    if (failures == 0) {
+        return;
+    }
+    checksum_failure_count_ += failures;
+    spdlog::warn("[{}] {} of {} records failed their checksum and were {} ({} so far)",
+                 Name(), failures, checked, drop_bad_checksums_ ? "dropped" : "kept", checksum_failure_count_);
+}
+
+size_t ByteStreamProcessorStage::parseConsecutiveRecords(
+    TClonesArray& out,
+    const CompiledParsePlan& plan,
+    const uint8_t* data,
+    size_t data_size,
+    size_t count,
+    size_t start_offset)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    if (!data) {
+        spdlog::error("[{}] Null data pointer passed for a record batch", Name());
+        return 0;
+    }
+
+    StageMetrics::ScopedTimer timer(metrics_, StageMetrics::kDecodeNs);
+
+    // Each record's start depends on the size of the one before, so this path is always serial
+    size_t offset = start_offset;
+    size_t decoded = 0;
+    for (; decoded < count; ++decoded) {
+        const Int_t idx = static_cast<Int_t>(decoded);
+        TObject* obj = out.ConstructedAt(idx, "C");
+        size_t record_size = 0;
+        if (!executePlan(plan, false, data, data_size, offset, obj, &record_size)) {
+            spdlog::error("[{}] Failed to decode record {} of {} for class '{}'",
+                          Name(), decoded, count, plan.GetClass()->GetName());
+            recordDecodeFailure(plan, CompiledParsePlan::LastFailedField());
+            out.RemoveAt(idx);
+            break;
+        }
+        offset += record_size;
+    }
+
+    metrics_.Add(StageMetrics::kRecordsDecoded, decoded);
+    metrics_.Add(StageMetrics::kBytesConsumed, offset - start_offset);
+    return decoded;
+}
@@ -0,0 +1,242 @@
+#include "analysis_pipeline/unpacker_core/utils/bit_unpack.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UNPACKER_CORE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr bool kHostLittleEndian = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+// Up to 8 bytes of the stream starting at `byte`, zero-padded past the end of the packed data
+inline uint64_t LoadStreamBytes(const uint8_t* src, size_t byte, size_t total_bytes, bool big_endian) {
+    uint8_t tmp[8] = {0};
+    const uint8_t* p = src + byte;
+    if (byte + 8 > total_bytes) {
+        std::memcpy(tmp, p, total_bytes - byte);
+        p = tmp;
+    }
+    return ByteSwap::Load<uint64_t>(p, big_endian == kHostLittleEndian);
+}
+
+// Generic path for any width up to 32 bits; each sample spans at most 5 bytes
+void UnpackScalar(void* dst, size_t dst_width, const uint8_t* src, size_t total_bytes,
+                  size_t bit_offset, size_t bit_width, size_t first, size_t count,
+                  bool msb_first, bool sign_extend) {
+    const uint64_t mask = (bit_width >= 64) ? ~0ULL : ((1ULL << bit_width) - 1);
+    const unsigned sign_shift = sign_extend ? static_cast<unsigned>(64 - bit_width) : 0;
+    uint8_t* out = static_cast<uint8_t*>(dst);
+
+    for (size_t i = first; i < count; ++i) {
+        const size_t pos = bit_offset + i * bit_width;
+        const size_t byte = pos >> 3;
+        const unsigned shift = static_cast<unsigned>(pos & 7);
+
+        uint64_t value;
+        if (msb_first) {
+            value = (LoadStreamBytes(src, byte, total_bytes, true) << shift) >> (64 - bit_width);
+        } else {
+            value = (LoadStreamBytes(src, byte, total_bytes, false) >> shift) & mask;
+        }
+        if (sign_shift) {
+            value = static_cast<uint64_t>(static_cast<int64_t>(value << sign_shift) >> sign_shift);
+        }
+        BitUnpack::StoreInteger(out + i * dst_width, dst_width, value);
+    }
+}
+
+#ifdef UNPACKER_CORE_X86_SIMD
+
+// 12-bit samples come in pairs of 3 bytes. Each shuffle gathers the two bytes holding
+// sample k into 16-bit lane k; even and odd samples then need a mask or a shift.
+__attribute__((target("ssse3")))
+size_t Unpack12Ssse3(uint8_t* out, const uint8_t* src, size_t total_bytes, size_t count,
+                     bool msb_first, bool sign_extend) {
+    const __m128i shuffle = msb_first
+        ? _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10)
+        : _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m128i even_lanes = _mm_setr_epi16(-1, 0, -1, 0, -1, 0, -1, 0);
+    const __m128i low12 = _mm_set1_epi16(0x0FFF);
+
+    size_t i = 0;
+    size_t in = 0;
+    for (; i + 8 <= count && in + 16 <= total_bytes; i += 8, in += 12) {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + in)), shuffle);
+        __m128i masked = _mm_and_si128(v, low12);
+        __m128i shifted = _mm_srli_epi16(v, 4);
+        __m128i even = msb_first ? shifted : masked;
+        __m128i odd = msb_first ? masked : shifted;
+        __m128i r = _mm_or_si128(_mm_and_si128(even_lanes, even), _mm_andnot_si128(even_lanes, odd));
+        if (sign_extend) {
+            r = _mm_srai_epi16(_mm_slli_epi16(r, 4), 4);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t Unpack12Avx2(uint8_t* out, const uint8_t* src, size_t total_bytes, size_t count,
+                    bool msb_first, bool sign_extend) {
+    const __m256i shuffle = msb_first
+        ? _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                           1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10)
+        : _mm256_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+                           0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m256i even_lanes = _mm256_setr_epi16(-1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0);
+    const __m256i low12 = _mm256_set1_epi16(0x0FFF);
+
+    size_t i = 0;
+    size_t in = 0;
+    // Each 128-bit lane takes 12 input bytes, so the two halves are loaded separately
+    for (; i + 16 <= count && in + 28 <= total_bytes; i += 16, in += 24) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + in));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + in + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+        __m256i masked = _mm256_and_si256(v, low12);
+        __m256i shifted = _mm256_srli_epi16(v, 4);
+        __m256i even = msb_first ? shifted : masked;
+        __m256i odd = msb_first ? masked : shifted;
+        __m256i r = _mm256_or_si256(_mm256_and_si256(even_lanes, even), _mm256_andnot_si256(even_lanes, odd));
+        if (sign_extend) {
+            r = _mm256_srai_epi16(_mm256_slli_epi16(r, 4), 4);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2), r);
+    }
+    return i + Unpack12Ssse3(out + i * 2, src + in, total_bytes - in, count - i, msb_first, sign_extend);
+}
+
+// Any width up to 16 bits (14-bit ADC samples, or 12-bit ones not starting on a byte) into
+// 16-bit elements. Eight samples always take exactly bit_width bytes, so every group of
+// eight sits at the same bit offset and one shuffle and one set of shifts serve them all.
+// Each 128-bit half gathers the 4 bytes holding each of its 4 samples into a 32-bit lane,
+// which is shifted into place and narrowed to 16 bits.
+__attribute__((target("avx2")))
+size_t UnpackNarrowAvx2(uint8_t* out, const uint8_t* src, size_t total_bytes, size_t bit_offset,
+                        size_t bit_width, size_t count, bool msb_first, bool sign_extend) {
+    const size_t high_start = (bit_offset + 4 * bit_width) / 8;  // first byte of samples 4..7
+    alignas(32) uint8_t shuffle_bytes[32];
+    alignas(32) uint32_t shifts[8];
+    for (size_t k = 0; k < 8; ++k) {
+        const size_t bit = bit_offset + k * bit_width - (k < 4 ? 0 : 8 * high_start);
+        const size_t byte = bit / 8;
+        for (size_t j = 0; j < 4; ++j) {
+            // MSB-first samples are read as big-endian words, so their bytes go in reversed
+            shuffle_bytes[k * 4 + j] = static_cast<uint8_t>(byte + (msb_first ? 3 - j : j));
+        }
+        shifts[k] = static_cast<uint32_t>(bit % 8);
+    }
+    const __m256i shuffle = _mm256_load_si256(reinterpret_cast<const __m256i*>(shuffle_bytes));
+    const __m256i shift = _mm256_load_si256(reinterpret_cast<const __m256i*>(shifts));
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>((1u << bit_width) - 1));
+    const __m128i spare_bits = _mm_cvtsi32_si128(static_cast<int>(32 - bit_width));
+
+    size_t i = 0;
+    size_t in = 0;
+    for (; i + 8 <= count && in + high_start + 16 <= total_bytes; i += 8, in += bit_width) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + in));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + in + high_start));
+        __m256i v = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), shuffle);
+        if (msb_first) {
+            // Sample at the top of the lane; the right shift drops the bits after it
+            v = _mm256_sllv_epi32(v, shift);
+            v = sign_extend ? _mm256_sra_epi32(v, spare_bits) : _mm256_srl_epi32(v, spare_bits);
+        } else {
+            v = _mm256_and_si256(_mm256_srlv_epi32(v, shift), mask);
+            if (sign_extend) {
+                v = _mm256_sra_epi32(_mm256_sll_epi32(v, spare_bits), spare_bits);
+            }
+        }
+        // Every lane fits 16 bits, signed or not, so the saturating pack does not clip
+        __m256i packed = sign_extend ? _mm256_packs_epi32(v, v) : _mm256_packus_epi32(v, v);
+        packed = _mm256_permute4x64_epi64(packed, 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm256_castsi256_si128(packed));
+    }
+    return i;
+}
+
+#endif // UNPACKER_CORE_X86_SIMD
+
+using Unpack12Kernel = size_t (*)(uint8_t* out, const uint8_t* src, size_t total_bytes, size_t count,
+                                  bool msb_first, bool sign_extend);
+
+Unpack12Kernel SelectUnpack12() {
+#ifdef UNPACKER_CORE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &Unpack12Avx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return &Unpack12Ssse3;
+    }
+#endif
+    return nullptr;
+}
+
+using UnpackNarrowKernel = size_t (*)(uint8_t* out, const uint8_t* src, size_t total_bytes, size_t bit_offset,
+                                      size_t bit_width, size_t count, bool msb_first, bool sign_extend);
+
+UnpackNarrowKernel SelectUnpackNarrow() {
+#ifdef UNPACKER_CORE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &UnpackNarrowAvx2;
+    }
+#endif
+    return nullptr;
+}
+
+} // namespace
+
+BitUnpack::FieldSpec BitUnpack::MakeFieldSpec(size_t word_size, bool swap, size_t bit_offset,
+                                              size_t bit_width, bool sign_extend) {
+    FieldSpec spec;
+    spec.word_size = static_cast<uint8_t>(word_size);
+    spec.swap = swap;
+    spec.shift = static_cast<uint8_t>(bit_offset);
+    spec.mask = (bit_width >= 64) ? ~0ULL : ((1ULL << bit_width) - 1);
+    spec.sign_shift = (sign_extend && bit_width < 64) ? static_cast<uint8_t>(64 - bit_width) : 0;
+    return spec;
+}
+
+void BitUnpack::StoreInteger(void* dst, size_t dst_width, uint64_t value) {
+    switch (dst_width) {
+        case 1: { uint8_t v = static_cast<uint8_t>(value); std::memcpy(dst, &v, 1); return; }
+        case 2: { uint16_t v = static_cast<uint16_t>(value); std::memcpy(dst, &v, 2); return; }
+        case 4: { uint32_t v = static_cast<uint32_t>(value); std::memcpy(dst, &v, 4); return; }
+        default: std::memcpy(dst, &value, 8); return;
+    }
+}
+
+void BitUnpack::UnpackArray(void* dst,
+                            size_t dst_width,
+                            const uint8_t* src,
+                            size_t bit_offset,
+                            size_t bit_width,
+                            size_t count,
+                            bool msb_first,
+                            bool sign_extend) {
+    src += bit_offset / 8;
+    bit_offset %= 8;
+    const size_t total_bytes = PackedBytes(bit_offset, bit_width, count);
+
+    size_t done = 0;
+    if (bit_width == 12 && dst_width == 2 && bit_offset == 0) {
+        static const Unpack12Kernel unpack12 = SelectUnpack12();
+        if (unpack12) {
+            done = unpack12(static_cast<uint8_t*>(dst), src, total_bytes, count, msb_first, sign_extend);
+        }
+    } else if (bit_width <= 16 && dst_width == 2) {
+        static const UnpackNarrowKernel unpack_narrow = SelectUnpackNarrow();
+        if (unpack_narrow) {
+            done = unpack_narrow(static_cast<uint8_t*>(dst), src, total_bytes, bit_offset, bit_width, count,
+                                 msb_first, sign_extend);
+        }
+    }
+
+    UnpackScalar(dst, dst_width, src, total_bytes, bit_offset, bit_width, done, count, msb_first, sign_extend);
+}
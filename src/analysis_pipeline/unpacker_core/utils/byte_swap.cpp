@@ -0,0 +1,158 @@
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UNPACKER_CORE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using ArrayKernel = void (*)(void* dst, const void* src, size_t count);
+
+template<typename T, T (*Swap)(T)>
+void SwapScalarTail(uint8_t* dst, const uint8_t* src, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        T v;
+        std::memcpy(&v, src + i * sizeof(T), sizeof(T));
+        v = Swap(v);
+        std::memcpy(dst + i * sizeof(T), &v, sizeof(T));
+    }
+}
+
+template<typename T, T (*Swap)(T)>
+void SwapArrayScalar(void* dst, const void* src, size_t count) {
+    SwapScalarTail<T, Swap>(static_cast<uint8_t*>(dst), static_cast<const uint8_t*>(src), count);
+}
+
+#ifdef UNPACKER_CORE_X86_SIMD
+
+// Byte reversal patterns within each 16-byte lane, listed most significant byte first
+// because that is the argument order of _mm_set_epi8
+#define UNPACKER_SWAP16_MASK 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1
+#define UNPACKER_SWAP32_MASK 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+#define UNPACKER_SWAP64_MASK 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7
+
+template<typename T, T (*Swap)(T), char... Mask>
+__attribute__((target("ssse3")))
+void SwapArraySsse3(void* dst, const void* src, size_t count) {
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    const __m128i shuffle = _mm_set_epi8(Mask...);
+    constexpr size_t per_vec = 16 / sizeof(T);
+
+    size_t i = 0;
+    for (; i + per_vec <= count; i += per_vec) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * sizeof(T)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * sizeof(T)), _mm_shuffle_epi8(v, shuffle));
+    }
+    SwapScalarTail<T, Swap>(out + i * sizeof(T), in + i * sizeof(T), count - i);
+}
+
+template<typename T, T (*Swap)(T), char... Mask>
+__attribute__((target("avx2")))
+void SwapArrayAvx2(void* dst, const void* src, size_t count) {
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    const __m256i shuffle = _mm256_set_epi8(Mask..., Mask...);
+    constexpr size_t per_vec = 32 / sizeof(T);
+
+    size_t i = 0;
+    // Two vectors per iteration keeps both shuffle ports busy on long waveforms
+    for (; i + 2 * per_vec <= count; i += 2 * per_vec) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * sizeof(T)));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + (i + per_vec) * sizeof(T)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * sizeof(T)), _mm256_shuffle_epi8(a, shuffle));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (i + per_vec) * sizeof(T)), _mm256_shuffle_epi8(b, shuffle));
+    }
+    for (; i + per_vec <= count; i += per_vec) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * sizeof(T)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * sizeof(T)), _mm256_shuffle_epi8(v, shuffle));
+    }
+    SwapScalarTail<T, Swap>(out + i * sizeof(T), in + i * sizeof(T), count - i);
+}
+
+#endif // UNPACKER_CORE_X86_SIMD
+
+struct KernelTable {
+    ArrayKernel swap16;
+    ArrayKernel swap32;
+    ArrayKernel swap64;
+    const char* name;
+};
+
+KernelTable SelectKernels() {
+#ifdef UNPACKER_CORE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {&SwapArrayAvx2<uint16_t, &ByteSwap::Swap16, UNPACKER_SWAP16_MASK>,
+                &SwapArrayAvx2<uint32_t, &ByteSwap::Swap32, UNPACKER_SWAP32_MASK>,
+                &SwapArrayAvx2<uint64_t, &ByteSwap::Swap64, UNPACKER_SWAP64_MASK>,
+                "avx2"};
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return {&SwapArraySsse3<uint16_t, &ByteSwap::Swap16, UNPACKER_SWAP16_MASK>,
+                &SwapArraySsse3<uint32_t, &ByteSwap::Swap32, UNPACKER_SWAP32_MASK>,
+                &SwapArraySsse3<uint64_t, &ByteSwap::Swap64, UNPACKER_SWAP64_MASK>,
+                "ssse3"};
+    }
+#endif
+    return {&SwapArrayScalar<uint16_t, &ByteSwap::Swap16>,
+            &SwapArrayScalar<uint32_t, &ByteSwap::Swap32>,
+            &SwapArrayScalar<uint64_t, &ByteSwap::Swap64>,
+            "scalar"};
+}
+
+const KernelTable& Kernels() {
+    static const KernelTable table = SelectKernels();
+    return table;
+}
+
+} // namespace
+
+void ByteSwap::SwapArray16(void* dst, const void* src, size_t count) {
+    Kernels().swap16(dst, src, count);
+}
+
+void ByteSwap::SwapArray32(void* dst, const void* src, size_t count) {
+    Kernels().swap32(dst, src, count);
+}
+
+void ByteSwap::SwapArray64(void* dst, const void* src, size_t count) {
+    Kernels().swap64(dst, src, count);
+}
+
+void ByteSwap::SwapArray(void* dst, const void* src, size_t element_size, size_t count) {
+    switch (element_size) {
+        case 1:
+            if (dst != src) {
+                std::memcpy(dst, src, count);
+            }
+            return;
+        case 2: SwapArray16(dst, src, count); return;
+        case 4: SwapArray32(dst, src, count); return;
+        case 8: SwapArray64(dst, src, count); return;
+        default: break;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* o = out + i * element_size;
+        const uint8_t* e = in + i * element_size;
+        for (size_t b = 0; b < element_size / 2; ++b) {
+            const uint8_t lo = e[b];
+            const uint8_t hi = e[element_size - 1 - b];
+            o[b] = hi;
+            o[element_size - 1 - b] = lo;
+        }
+        if (element_size % 2 != 0) {
+            o[element_size / 2] = e[element_size / 2];
+        }
+    }
+}
+
+const char* ByteSwap::ActiveKernelName() {
+    return Kernels().name;
+}
@@ -0,0 +1,80 @@
+#include "analysis_pipeline/unpacker_core/utils/column_decoder.h"
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+
+#include <cstring>
+
+namespace {
+
+// One element per record. A strided gather with a runtime stride does not vectorize, so it
+// only moves bytes; the byte-order pass then runs over the contiguous column with the SIMD
+// swap kernels while the column is still in cache.
+template<typename T>
+void GatherScalars(uint8_t* __restrict column, const uint8_t* __restrict src, size_t stride, size_t count, bool swap) {
+    if (stride == sizeof(T)) {
+        std::memcpy(column, src, count * sizeof(T));
+    } else {
+        T* __restrict out = reinterpret_cast<T*>(column);
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(&out[i], src + i * stride, sizeof(T));
+        }
+    }
+    if (swap) {
+        ByteSwap::SwapArray(column, column, sizeof(T), count);
+    }
+}
+
+} // namespace
+
+bool ColumnDecoder::Supports(const CompiledParsePlan::FieldOp& field) {
+    return !field.dynamic && (field.kernel || field.bit_width);
+}
+
+void ColumnDecoder::Decode(const CompiledParsePlan::FieldOp& field,
+                           const uint8_t* data,
+                           size_t data_size,
+                           size_t start_offset,
+                           size_t stride,
+                           size_t first,
+                           size_t count,
+                           uint8_t* column) {
+    // End-relative fields sit at the same place for every record
+    const uint8_t* src;
+    size_t src_stride;
+    if (field.source_offset >= 0) {
+        src = data + start_offset + first * stride + static_cast<size_t>(field.source_offset);
+        src_stride = stride;
+    } else {
+        src = data + data_size + field.source_offset;
+        src_stride = 0;
+    }
+
+    const size_t record_bytes = field.element_size * field.count;
+    uint8_t* out = column + first * record_bytes;
+
+    if (field.bit_width) {
+        for (size_t i = 0; i < count; ++i) {
+            CompiledParsePlan::DecodeBits(field, out + i * record_bytes, src + i * src_stride);
+        }
+        return;
+    }
+
+    if (field.count == 1) {
+        switch (field.element_size) {
+            case 1: GatherScalars<uint8_t>(out, src, src_stride, count, false); return;
+            case 2: GatherScalars<uint16_t>(out, src, src_stride, count, field.swap); return;
+            case 4: GatherScalars<uint32_t>(out, src, src_stride, count, field.swap); return;
+            case 8: GatherScalars<uint64_t>(out, src, src_stride, count, field.swap); return;
+            default: break;
+        }
+    }
+
+    // Back-to-back records holding only this field are one contiguous run
+    if (src_stride == record_bytes) {
+        field.kernel(out, src, field.count * count);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        field.kernel(out + i * record_bytes, src + i * src_stride, field.count);
+    }
+}
@@ -0,0 +1,612 @@
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace {
+
+// Field behind the calling thread's last failed Execute(); only written on failure
+thread_local const std::string* t_failed_field = nullptr;
+
+inline bool FailAt(const CompiledParsePlan::FieldOp& op) {
+    t_failed_field = &op.name;
+    return false;
+}
+
+// Bit extraction only makes sense for integer members (scalar or array<INT,N>)
+bool IsIntegerType(const std::string& type_name) {
+    std::string base = type_name;
+    if (base.compare(0, 6, "array<") == 0) {
+        base = base.substr(6, base.find(',') - 6);
+    }
+    return base != "float" && base != "double" && base != "bool" && base != "Float_t" && base != "Double_t" &&
+           base != "Bool_t" && base != "Double32_t" && base != "Float16_t" && base != "long double";
+}
+
+// "float", "Double_t", "array<float,4>" and so on are floating point; "unsigned ...",
+// ROOT's U* typedefs, uint*_t and bool are unsigned
+CompiledParsePlan::ValueKind ValueKindOf(const std::string& type_name) {
+    std::string base = type_name;
+    if (base.compare(0, 6, "array<") == 0) {
+        base = base.substr(6, base.find(',') - 6);
+    } else if (base.compare(0, 7, "vector<") == 0) {
+        base = base.substr(7, base.size() - 8);
+    }
+    if (base.find("float") != std::string::npos || base.find("double") != std::string::npos ||
+        base.find("Float") != std::string::npos || base.find("Double") != std::string::npos) {
+        return CompiledParsePlan::ValueKind::kFloat;
+    }
+    if (base.compare(0, 8, "unsigned") == 0 || base.compare(0, 4, "uint") == 0 || base.compare(0, 1, "U") == 0 ||
+        base == "bool" || base == "Bool_t" || base == "size_t") {
+        return CompiledParsePlan::ValueKind::kUnsigned;
+    }
+    return CompiledParsePlan::ValueKind::kSigned;
+}
+
+// Raw element bits, zero-extended
+uint64_t LoadElement(const void* src, size_t size, bool swap) {
+    switch (size) {
+        case 1: return *static_cast<const uint8_t*>(src);
+        case 2: return ByteSwap::Load<uint16_t>(src, swap);
+        case 4: return ByteSwap::Load<uint32_t>(src, swap);
+        default: return ByteSwap::Load<uint64_t>(src, swap);
+    }
+}
+
+inline bool DecodeField(const CompiledParsePlan::FieldOp& op,
+                        char* base,
+                        const uint8_t* buffer,
+                        size_t buffer_size,
+                        size_t abs_offset,
+                        TObject* obj) {
+    if (op.kernel) {
+        op.kernel(base + op.member_offset, buffer + abs_offset, op.count);
+    } else if (op.bit_width) {
+        CompiledParsePlan::DecodeBits(op, base + op.member_offset, buffer + abs_offset);
+    } else if (!op.handler(buffer, buffer_size, abs_offset, op.little_endian, obj, op.member)) {
+        spdlog::error("CompiledParsePlan: Handler failed for field '{}'", op.name);
+        return FailAt(op);
+    }
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<const CompiledParsePlan> CompiledParsePlan::Compile(const nlohmann::json& json_field_mapping,
+                                                                    TClass* cls) {
+    if (!cls) {
+        spdlog::error("CompiledParsePlan: Null TClass");
+        return nullptr;
+    }
+
+    if (!json_field_mapping.is_object()) {
+        spdlog::error("CompiledParsePlan: Field mapping for class '{}' is not a JSON object", cls->GetName());
+        return nullptr;
+    }
+
+    const TypeRegistry& registry = TypeRegistry::Instance();
+    std::shared_ptr<CompiledParsePlan> plan(new CompiledParsePlan());
+    plan->cls_ = cls;
+    plan->ops_.reserve(json_field_mapping.size());
+
+    // (count_from, after) names per op, resolved once every field is known
+    std::vector<std::pair<std::string, std::string>> links;
+
+    for (auto it = json_field_mapping.begin(); it != json_field_mapping.end(); ++it) {
+        const std::string& member_name = it.key();
+        const nlohmann::json& field_info = it.value();
+
+        TDataMember* member = cls->GetDataMember(member_name.c_str());
+        if (!member) {
+            spdlog::error("CompiledParsePlan: Member '{}' not found in class '{}'", member_name, cls->GetName());
+            return nullptr;
+        }
+
+        const bool variable = field_info.contains("count_from") || field_info.contains("terminator");
+        if (!field_info.contains("offset") || !field_info.contains("endianness") ||
+            (!variable && !field_info.contains("size"))) {
+            spdlog::error("CompiledParsePlan: Missing offset/size/endianness for field '{}'", member_name);
+            return nullptr;
+        }
+        links.emplace_back(field_info.value("count_from", std::string()), field_info.value("after", std::string()));
+
+        FieldOp op;
+        op.name = member_name;
+        op.member = member;
+        op.member_offset = static_cast<size_t>(member->GetOffset());
+        op.source_offset = field_info["offset"].get<int64_t>();
+        op.size = field_info.value("size", static_cast<size_t>(0));
+        op.little_endian = (field_info["endianness"].get<std::string>() == "little");
+        op.swap = (op.little_endian != registry.IsSystemLittleEndian());
+
+        const std::string type_name = member->GetTypeName();
+        op.value_kind = ValueKindOf(type_name);
+
+        if (registry.HasCustomHandler(type_name)) {
+            op.handler = registry.GetHandler(type_name);
+            plan->ops_.push_back(std::move(op));
+            continue;
+        }
+
+        if (variable) {
+            if (!CompileVectorField(field_info, type_name, op)) {
+                return nullptr;
+            }
+            plan->ops_.push_back(std::move(op));
+            continue;
+        }
+
+        size_t element_size = 0;
+        size_t count = 0;
+        if (!registry.ResolveLayout(type_name, element_size, count)) {
+            spdlog::error("CompiledParsePlan: No handler registered for type '{}' (field '{}')", type_name, member_name);
+            return nullptr;
+        }
+
+        if (field_info.contains("bit_width")) {
+            if (!CompileBitField(field_info, type_name, element_size, count, op)) {
+                return nullptr;
+            }
+            plan->ops_.push_back(std::move(op));
+            continue;
+        }
+
+        op.kernel = TypeRegistry::GetCopyKernel(element_size, op.swap);
+        if (!op.kernel) {
+            spdlog::error("CompiledParsePlan: Unsupported element size {} for field '{}' of type '{}'",
+                          element_size, member_name, type_name);
+            return nullptr;
+        }
+
+        // The handlers always read the full type width, so the mapped size only ever widens the bounds check
+        op.element_size = element_size;
+        op.count = count;
+        op.size = std::max(op.size, element_size * count);
+        plan->ops_.push_back(std::move(op));
+    }
+
+    plan->stats_.fields = plan->ops_.size();
+    if (!plan->ResolveDynamicFields(links)) {
+        return nullptr;
+    }
+    plan->fields_ = plan->ops_;
+    plan->ops_.erase(std::remove_if(plan->ops_.begin(), plan->ops_.end(),
+                                    [](const FieldOp& op) { return op.dynamic; }),
+                     plan->ops_.end());
+    plan->Coalesce();
+    plan->stats_.ops = plan->ops_.size() + plan->dynamic_ops_.size();
+
+    spdlog::debug("CompiledParsePlan: Class '{}' compiled {} fields into {} ops ({} fields coalesced into {} bulk copies)",
+                  cls->GetName(), plan->stats_.fields, plan->stats_.ops,
+                  plan->stats_.coalesced_fields, plan->stats_.coalesced_runs);
+
+    return plan;
+}
+
+bool CompiledParsePlan::CompileBitField(const nlohmann::json& field_info,
+                                        const std::string& type_name,
+                                        size_t element_size,
+                                        size_t count,
+                                        FieldOp& op) {
+    if (!IsIntegerType(type_name)) {
+        spdlog::error("CompiledParsePlan: Bit field '{}' must be an integer member, not '{}'", op.name, type_name);
+        return false;
+    }
+
+    op.element_size = element_size;
+    op.count = count;
+    op.bit_offset = field_info.value("bit_offset", static_cast<size_t>(0));
+    op.bit_width = field_info["bit_width"].get<size_t>();
+    op.sign_extend = field_info.value("signed", false);
+
+    if (op.bit_width == 0 || op.bit_width > element_size * 8) {
+        spdlog::error("CompiledParsePlan: Bit width {} of field '{}' does not fit its {}-byte member",
+                      op.bit_width, op.name, element_size);
+        return false;
+    }
+
+    if (count == 1) {
+        const size_t word_size = op.size;
+        if (word_size != 1 && word_size != 2 && word_size != 4 && word_size != 8) {
+            spdlog::error("CompiledParsePlan: Bit field '{}' needs a 1, 2, 4 or 8 byte word, got {}", op.name, word_size);
+            return false;
+        }
+        if (op.bit_offset + op.bit_width > word_size * 8) {
+            spdlog::error("CompiledParsePlan: Bits {}..{} of field '{}' exceed its {}-byte word",
+                          op.bit_offset, op.bit_offset + op.bit_width, op.name, word_size);
+            return false;
+        }
+        op.bits = BitUnpack::MakeFieldSpec(word_size, op.swap, op.bit_offset, op.bit_width, op.sign_extend);
+        return true;
+    }
+
+    if (op.bit_width > 32) {
+        spdlog::error("CompiledParsePlan: Packed samples of field '{}' are limited to 32 bits, got {}", op.name, op.bit_width);
+        return false;
+    }
+    op.size = std::max(op.size, BitUnpack::PackedBytes(op.bit_offset, op.bit_width, count));
+    return true;
+}
+
+bool CompiledParsePlan::CompileVectorField(const nlohmann::json& field_info,
+                                           const std::string& type_name,
+                                           FieldOp& op) {
+    if (field_info.contains("count_from") && field_info.contains("terminator")) {
+        spdlog::error("CompiledParsePlan: Field '{}' sets both count_from and terminator", op.name);
+        return false;
+    }
+
+    size_t element_size = 0;
+    TypeRegistry::VectorResize resize = nullptr;
+    if (!TypeRegistry::Instance().ResolveVectorLayout(type_name, element_size, resize)) {
+        spdlog::error("CompiledParsePlan: Variable-length field '{}' must be a vector of a built-in type, not '{}'",
+                      op.name, type_name);
+        return false;
+    }
+
+    op.dynamic = true;
+    op.resize = resize;
+    op.element_size = element_size;
+    op.count = 0;
+    op.size = 0;
+    op.kernel = TypeRegistry::GetCopyKernel(element_size, op.swap);
+    op.max_count = field_info.value("max_count", static_cast<size_t>(0));
+
+    if (field_info.contains("terminator")) {
+        op.terminated = true;
+        op.terminator = static_cast<uint64_t>(field_info["terminator"].get<int64_t>());
+        if (element_size < 8) {
+            op.terminator &= (uint64_t{1} << (element_size * 8)) - 1;
+        }
+    }
+    return true;
+}
+
+bool CompiledParsePlan::ResolveDynamicFields(const std::vector<std::pair<std::string, std::string>>& links) {
+    auto find = [this](const std::string& name) {
+        for (size_t i = 0; i < ops_.size(); ++i) {
+            if (ops_[i].name == name) {
+                return i;
+            }
+        }
+        return kNoField;
+    };
+
+    // Dependencies as indices into ops_: the anchor, and the count field when it is itself dynamic
+    std::vector<size_t> anchors(ops_.size(), kNoField);
+
+    for (size_t i = 0; i < ops_.size(); ++i) {
+        FieldOp& op = ops_[i];
+        const std::string& count_from = links[i].first;
+        const std::string& after = links[i].second;
+
+        if (!count_from.empty()) {
+            const size_t j = find(count_from);
+            if (j == kNoField) {
+                spdlog::error("CompiledParsePlan: count_from '{}' of field '{}' is not a mapped field", count_from, op.name);
+                return false;
+            }
+            const FieldOp& count_op = ops_[j];
+            if (count_op.resize || count_op.count != 1 || count_op.element_size > 8 ||
+                (!count_op.kernel && !count_op.bit_width) || !IsIntegerType(count_op.member->GetTypeName())) {
+                spdlog::error("CompiledParsePlan: count_from '{}' of field '{}' must be a scalar integer field",
+                              count_from, op.name);
+                return false;
+            }
+            op.count_field = j;
+        }
+
+        if (!after.empty()) {
+            const size_t j = find(after);
+            if (j == kNoField) {
+                spdlog::error("CompiledParsePlan: after '{}' of field '{}' is not a mapped field", after, op.name);
+                return false;
+            }
+            anchors[i] = j;
+            op.dynamic = true;
+        }
+
+        if (op.dynamic && op.source_offset < 0) {
+            spdlog::error("CompiledParsePlan: Variable-position field '{}' cannot use an end-relative offset", op.name);
+            return false;
+        }
+    }
+
+    // Anchors must themselves have a per-record position
+    for (size_t i = 0; i < ops_.size(); ++i) {
+        if (anchors[i] != kNoField && !ops_[anchors[i]].dynamic) {
+            spdlog::error("CompiledParsePlan: Field '{}' is placed after '{}', which has a fixed offset; use its offset instead",
+                          ops_[i].name, ops_[anchors[i]].name);
+            return false;
+        }
+    }
+
+    // Order dynamic ops so anchors and dynamic count fields are decoded first
+    std::vector<size_t> slots(ops_.size(), kNoField);
+    size_t placed = 0;
+    size_t total = 0;
+    for (const FieldOp& op : ops_) {
+        total += op.dynamic ? 1 : 0;
+    }
+
+    if (total > kMaxDynamicFields) {
+        spdlog::error("CompiledParsePlan: Class '{}' has {} variable-position fields, at most {} are supported",
+                      cls_->GetName(), total, kMaxDynamicFields);
+        return false;
+    }
+
+    while (placed < total) {
+        const size_t before = placed;
+        for (size_t i = 0; i < ops_.size(); ++i) {
+            FieldOp& op = ops_[i];
+            if (!op.dynamic || slots[i] != kNoField) {
+                continue;
+            }
+            const size_t anchor = anchors[i];
+            const size_t count_field = op.count_field;
+            if ((anchor != kNoField && slots[anchor] == kNoField) ||
+                (count_field != kNoField && ops_[count_field].dynamic && slots[count_field] == kNoField)) {
+                continue;
+            }
+            op.slot = placed;
+            op.anchor_slot = (anchor != kNoField) ? slots[anchor] : kNoField;
+            slots[i] = placed++;
+            dynamic_ops_.push_back(op);
+        }
+        if (placed == before) {
+            spdlog::error("CompiledParsePlan: Circular after/count_from references in class '{}'", cls_->GetName());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CompiledParsePlan::Coalesce() {
+    // Record-relative fields first, in source order, so adjacent fields can be merged and
+    // a single extent check covers all of them; buffer-end relative fields keep their own checks
+    auto relative_end = std::stable_partition(ops_.begin(), ops_.end(),
+                                              [](const FieldOp& op) { return op.source_offset >= 0; });
+    std::stable_sort(ops_.begin(), relative_end, [](const FieldOp& a, const FieldOp& b) {
+        return a.source_offset < b.source_offset;
+    });
+
+    auto is_plain_copy = [](const FieldOp& op) {
+        return op.kernel && (!op.swap || op.element_size == 1) && op.size == op.element_size * op.count;
+    };
+
+    std::vector<FieldOp> merged;
+    merged.reserve(ops_.size());
+
+    for (auto it = ops_.begin(); it != ops_.end(); ++it) {
+        const bool relative = (it < relative_end);
+        if (relative) {
+            record_extent_ = std::max(record_extent_, static_cast<size_t>(it->source_offset) + it->size);
+        }
+
+        if (relative && !merged.empty() && is_plain_copy(*it) && is_plain_copy(merged.back()) &&
+            merged.back().source_offset >= 0) {
+            FieldOp& run = merged.back();
+            const size_t run_bytes = run.size;
+            if (static_cast<size_t>(run.source_offset) + run_bytes == static_cast<size_t>(it->source_offset) &&
+                run.member_offset + run_bytes == it->member_offset) {
+                if (run.field_count == 1) {
+                    run.kernel = TypeRegistry::GetCopyKernel(1, false);
+                    run.element_size = 1;
+                    run.count = run_bytes;
+                }
+                run.size += it->size;
+                run.count += it->size;
+                run.field_count += it->field_count;
+                run.name += "," + it->name;
+                continue;
+            }
+        }
+
+        merged.push_back(std::move(*it));
+    }
+
+    for (const FieldOp& op : merged) {
+        if (op.field_count > 1) {
+            stats_.coalesced_fields += op.field_count;
+            ++stats_.coalesced_runs;
+        }
+    }
+
+    ops_ = std::move(merged);
+}
+
+const std::string* CompiledParsePlan::LastFailedField() {
+    return t_failed_field;
+}
+
+size_t CompiledParsePlan::FindField(const std::string& name) const {
+    for (size_t i = 0; i < fields_.size(); ++i) {
+        if (fields_[i].name == name) {
+            return i;
+        }
+    }
+    return kNoField;
+}
+
+bool CompiledParsePlan::CheckRange(size_t buffer_size, size_t first_offset, size_t last_offset) const {
+    if (first_offset > last_offset || last_offset > buffer_size || record_extent_ > buffer_size - last_offset) {
+        return false;
+    }
+    for (const FieldOp& op : ops_) {
+        if (op.source_offset < 0 &&
+            (static_cast<size_t>(-op.source_offset) > buffer_size || op.size > static_cast<size_t>(-op.source_offset))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CompiledParsePlan::Execute(const uint8_t* buffer,
+                                size_t buffer_size,
+                                size_t start_offset,
+                                TObject* obj,
+                                size_t* record_size) const {
+    if (obj->IsA() != cls_) {
+        spdlog::error("CompiledParsePlan: Plan compiled for class '{}' applied to object of class '{}'",
+                      cls_->GetName(), obj->ClassName());
+        t_failed_field = nullptr;
+        return false;
+    }
+
+    // One check covers every fixed field; if it fails, the checked walk names the culprit
+    if (CheckRange(buffer_size, start_offset, start_offset)) {
+        return ExecuteOps<false>(buffer, buffer_size, start_offset, obj, record_size);
+    }
+    return ExecuteOps<true>(buffer, buffer_size, start_offset, obj, record_size);
+}
+
+bool CompiledParsePlan::ExecuteChecked(const uint8_t* buffer,
+                                       size_t buffer_size,
+                                       size_t start_offset,
+                                       TObject* obj,
+                                       size_t* record_size) const {
+    if (obj->IsA() != cls_) {
+        spdlog::error("CompiledParsePlan: Plan compiled for class '{}' applied to object of class '{}'",
+                      cls_->GetName(), obj->ClassName());
+        t_failed_field = nullptr;
+        return false;
+    }
+    return ExecuteOps<true>(buffer, buffer_size, start_offset, obj, record_size);
+}
+
+bool CompiledParsePlan::ExecuteTrusted(const uint8_t* buffer,
+                                       size_t buffer_size,
+                                       size_t start_offset,
+                                       TObject* obj,
+                                       size_t* record_size) const {
+    return ExecuteOps<false>(buffer, buffer_size, start_offset, obj, record_size);
+}
+
+template<bool kCheckFields>
+bool CompiledParsePlan::ExecuteOps(const uint8_t* buffer,
+                                   size_t buffer_size,
+                                   size_t start_offset,
+                                   TObject* obj,
+                                   size_t* record_size) const {
+    char* base = reinterpret_cast<char*>(obj);
+
+    for (const FieldOp& op : ops_) {
+        size_t abs_offset;
+        if (op.source_offset >= 0) {
+            abs_offset = start_offset + static_cast<size_t>(op.source_offset);
+        } else {
+            if (kCheckFields && static_cast<size_t>(-op.source_offset) > buffer_size) {
+                spdlog::error("CompiledParsePlan: Negative offset {} out of range for field '{}'", op.source_offset, op.name);
+                return FailAt(op);
+            }
+            abs_offset = buffer_size + op.source_offset;
+        }
+
+        if (kCheckFields && (start_offset > buffer_size || abs_offset > buffer_size || op.size > buffer_size - abs_offset)) {
+            spdlog::error("CompiledParsePlan: Field '{}' (offset {}, size {}) out of buffer bounds (size {})",
+                          op.name, abs_offset, op.size, buffer_size);
+            return FailAt(op);
+        }
+
+        if (!DecodeField(op, base, buffer, buffer_size, abs_offset, obj)) {
+            return false;
+        }
+    }
+
+    if (!dynamic_ops_.empty()) {
+        return ExecuteDynamic(buffer, buffer_size, start_offset, obj, record_size);
+    }
+
+    if (record_size) {
+        *record_size = record_extent_;
+    }
+    return true;
+}
+
+bool CompiledParsePlan::ExecuteDynamic(const uint8_t* buffer,
+                                       size_t buffer_size,
+                                       size_t start_offset,
+                                       TObject* obj,
+                                       size_t* record_size) const {
+    char* base = reinterpret_cast<char*>(obj);
+    size_t ends[kMaxDynamicFields];
+    size_t record_end = start_offset + record_extent_;
+
+    for (const FieldOp& op : dynamic_ops_) {
+        const size_t origin = (op.anchor_slot != kNoField) ? ends[op.anchor_slot] : start_offset;
+        const size_t abs_offset = origin + static_cast<size_t>(op.source_offset);
+        if (abs_offset > buffer_size) {
+            spdlog::error("CompiledParsePlan: Field '{}' starts at {}, past the buffer end ({})",
+                          op.name, abs_offset, buffer_size);
+            return FailAt(op);
+        }
+
+        size_t end;
+        if (op.resize) {
+            if (!DecodeVector(op, base, buffer, buffer_size, abs_offset, end)) {
+                return false;
+            }
+        } else {
+            if (op.size > buffer_size - abs_offset) {
+                spdlog::error("CompiledParsePlan: Field '{}' (offset {}, size {}) out of buffer bounds (size {})",
+                              op.name, abs_offset, op.size, buffer_size);
+                return FailAt(op);
+            }
+            if (!DecodeField(op, base, buffer, buffer_size, abs_offset, obj)) {
+                return false;
+            }
+            end = abs_offset + op.size;
+        }
+
+        ends[op.slot] = end;
+        record_end = std::max(record_end, end);
+    }
+
+    if (record_size) {
+        *record_size = record_end - start_offset;
+    }
+    return true;
+}
+
+bool CompiledParsePlan::DecodeVector(const FieldOp& op,
+                                     char* base,
+                                     const uint8_t* buffer,
+                                     size_t buffer_size,
+                                     size_t abs_offset,
+                                     size_t& end) const {
+    const uint8_t* src = buffer + abs_offset;
+    const size_t available = (buffer_size - abs_offset) / op.element_size;
+    size_t count = 0;
+    size_t consumed = 0;
+
+    if (op.terminated) {
+        const size_t limit = op.max_count ? std::min(available, op.max_count + 1) : available;
+        while (count < limit && LoadElement(src + count * op.element_size, op.element_size, op.swap) != op.terminator) {
+            ++count;
+        }
+        if (count == limit) {
+            spdlog::error("CompiledParsePlan: No terminator for field '{}' within {} elements", op.name, limit);
+            return FailAt(op);
+        }
+        consumed = (count + 1) * op.element_size;
+    } else {
+        // The count member was decoded earlier in this record, so it is already in host order
+        const FieldOp& count_op = fields_[op.count_field];
+        count = LoadElement(base + count_op.member_offset, count_op.element_size, false);
+        if (count > available || (op.max_count && count > op.max_count)) {
+            spdlog::error("CompiledParsePlan: Field '{}' claims {} elements, only {} fit in the buffer (max_count {})",
+                          op.name, count, available, op.max_count);
+            return FailAt(op);
+        }
+        consumed = count * op.element_size;
+    }
+
+    // resize() keeps the capacity of recycled objects, so steady state does not allocate
+    uint8_t* dst = op.resize(base + op.member_offset, count);
+    if (count > 0) {
+        op.kernel(dst, src, count);
+    }
+    end = abs_offset + consumed;
+    return true;
+}
@@ -1,5 +1,4 @@
 #include "analysis_pipeline/unpacker_core/utils/field_mapping_parser.h"
-#include "analysis_pipeline/unpacker_core/utils/type_registry.h"
 #include <spdlog/spdlog.h>
 
 bool FieldMappingParser::ParseAndFill(const uint8_t* buffer,
@@ -18,78 +17,57 @@ bool FieldMappingParser::ParseAndFill(const uint8_t* buffer,
         return false;
     }
 
-    for (auto it = json_field_mapping.begin(); it != json_field_mapping.end(); ++it) {
-        const std::string& member_name = it.key();
-        const nlohmann::json& field_info = it.value();
-
-        //spdlog::debug("Parsing field '{}': {}", member_name, field_info.dump());
-
-        if (!ExtractAndAssignField(buffer, buffer_size, start_offset, member_name, field_info, obj)) {
-            spdlog::error("FieldMappingParser: Failed to extract/assign field '{}'", member_name);
-            return false;
-        }
+    const auto plan = GetPlan(json_field_mapping, cls);
+    if (!plan) {
+        spdlog::error("FieldMappingParser: Failed to compile field mapping for class '{}'", cls->GetName());
+        return false;
     }
 
-    return true;
+    return ParseAndFill(buffer, buffer_size, start_offset, *plan, obj);
 }
 
-bool FieldMappingParser::ExtractAndAssignField(const uint8_t* buffer,
-                                               size_t buffer_size,
-                                               size_t start_offset,
-                                               const std::string& member_name,
-                                               const nlohmann::json& field_info,
-                                               TObject* obj) {
-    TClass* cls = obj->IsA();
-    if (!cls) return false;
-
-    TDataMember* member = cls->GetDataMember(member_name.c_str());
-    if (!member) {
-        spdlog::error("FieldMappingParser: Member '{}' not found in class '{}'", member_name, cls->GetName());
+bool FieldMappingParser::ParseAndFill(const uint8_t* buffer,
+                                      size_t buffer_size,
+                                      size_t start_offset,
+                                      const CompiledParsePlan& plan,
+                                      TObject* obj) const {
+    if (!buffer || !obj) {
+        spdlog::error("FieldMappingParser: Null buffer or object pointer");
         return false;
     }
 
-    if (!field_info.contains("offset") || !field_info.contains("size") || !field_info.contains("endianness")) {
-        spdlog::error("FieldMappingParser: Missing offset/size/endianness for field '{}'", member_name);
+    if (!plan.Execute(buffer, buffer_size, start_offset, obj)) {
+        spdlog::error("FieldMappingParser: Failed to fill object of class '{}'", plan.GetClass()->GetName());
         return false;
     }
 
-    int64_t offset = field_info["offset"].get<int64_t>();
-    size_t size = field_info["size"].get<size_t>();
-    std::string endian_str = field_info["endianness"].get<std::string>();
-    bool little_endian = (endian_str == "little");
-
-    // Compute absolute offset
-    size_t abs_offset;
-    if (offset >= 0) {
-        abs_offset = start_offset + static_cast<size_t>(offset);
-    } else {
-        if (static_cast<size_t>(-offset) > buffer_size) {
-            spdlog::error("FieldMappingParser: Negative offset {} out of range for field '{}'", offset, member_name);
-            return false;
-        }
-        abs_offset = buffer_size + offset; // offset negative
-    }
+    return true;
+}
 
-    if (abs_offset + size > buffer_size) {
-        spdlog::error("FieldMappingParser: Field '{}' (offset {}, size {}) out of buffer bounds (size {})",
-                      member_name, abs_offset, size, buffer_size);
+bool FieldMappingParser::ParseAndFillTrusted(const uint8_t* buffer,
+                                             size_t buffer_size,
+                                             size_t start_offset,
+                                             const CompiledParsePlan& plan,
+                                             TObject* obj) const {
+    if (!plan.ExecuteTrusted(buffer, buffer_size, start_offset, obj)) {
+        spdlog::error("FieldMappingParser: Failed to fill object of class '{}'", plan.GetClass()->GetName());
         return false;
     }
 
-    const std::string& type_name = member->GetTypeName();
+    return true;
+}
 
-    // Get handler from TypeRegistry
-    auto handler = TypeRegistry::Instance().GetHandler(type_name);
-    if (!handler) {
-        spdlog::error("FieldMappingParser: No handler registered for type '{}' (field '{}')", type_name, member_name);
-        return false;
+std::shared_ptr<const CompiledParsePlan> FieldMappingParser::GetPlan(const nlohmann::json& json_field_mapping,
+                                                                    TClass* cls) {
+    PlanKey key(json_field_mapping.dump(), cls);
+    auto it = plan_cache_.find(key);
+    if (it != plan_cache_.end()) {
+        return it->second;
     }
 
-    // Invoke handler
-    if (!handler(buffer, buffer_size, abs_offset, little_endian, obj, member)) {
-        spdlog::error("FieldMappingParser: Handler failed for field '{}' of type '{}'", member_name, type_name);
-        return false;
+    // Plans are shared, so callers holding one are unaffected by the reset
+    if (plan_cache_.size() >= kMaxCachedPlans) {
+        plan_cache_.clear();
     }
-
-    return true;
+    return plan_cache_.emplace(std::move(key), CompiledParsePlan::Compile(json_field_mapping, cls)).first->second;
 }
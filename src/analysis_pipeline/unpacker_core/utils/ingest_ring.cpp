@@ -0,0 +1,139 @@
+#include "analysis_pipeline/unpacker_core/utils/ingest_ring.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+std::shared_ptr<IngestRing> IngestRing::Create(size_t slots, Policy policy, std::chrono::milliseconds block_timeout) {
+    return std::shared_ptr<IngestRing>(new IngestRing(slots, policy, block_timeout));
+}
+
+IngestRing::IngestRing(size_t slots, Policy policy, std::chrono::milliseconds block_timeout)
+    : policy_(policy), block_timeout_(block_timeout) {
+    slots_.resize(std::max<size_t>(1, slots));
+    for (auto& slot : slots_) {
+        slot = std::make_unique<Slot>();
+    }
+}
+
+bool IngestRing::ParsePolicy(const std::string& name, Policy& policy) {
+    if (name == "block") {
+        policy = Policy::kBlock;
+    } else if (name == "drop") {
+        policy = Policy::kDrop;
+    } else if (name == "grow") {
+        policy = Policy::kGrow;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+IngestRing::Slot* IngestRing::FindFreeLocked() {
+    for (auto& slot : slots_) {
+        if (slot) {
+            return slot.release();  // the Bank owns it until Release()
+        }
+    }
+    return nullptr;
+}
+
+IngestRing::Reservation IngestRing::Reserve() {
+    Slot* slot = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        slot = FindFreeLocked();
+        if (!slot && policy_ == Policy::kBlock) {
+            released_.wait_for(lock, block_timeout_, [this] { return leased_ < slots_.size(); });
+            slot = FindFreeLocked();
+        }
+        if (!slot && policy_ == Policy::kGrow) {
+            slots_.emplace_back();
+            slot = new Slot();
+            spdlog::debug("IngestRing: All slots leased; growing to {}", slots_.size());
+        }
+        if (!slot) {
+            ++sequence_;
+            ++dropped_;
+            return Reservation();
+        }
+        ++leased_;
+    }
+
+    Reservation reservation;
+    reservation.slot_ = std::shared_ptr<Slot>(slot, Releaser{weak_from_this()});
+    return reservation;
+}
+
+IngestRing::Bank IngestRing::Fill(Reservation reservation, const uint8_t* data, size_t size) {
+    if (!reservation) {
+        return Bank();
+    }
+
+    // Capacity is kept across banks, so steady-state capture is a plain copy
+    Slot* slot = reservation.slot_.get();
+    slot->bytes.resize(size);
+    if (size > 0) {
+        std::memcpy(slot->bytes.data(), data, size);
+    }
+
+    Bank bank;
+    bank.owner = std::move(reservation.slot_);
+    bank.data = slot->bytes.data();
+    bank.size = size;
+    std::lock_guard<std::mutex> lock(mutex_);
+    bank.sequence = ++sequence_;
+    return bank;
+}
+
+IngestRing::Bank IngestRing::Copy(const uint8_t* data, size_t size) {
+    return Fill(Reserve(), data, size);
+}
+
+IngestRing::Bank IngestRing::Share(std::shared_ptr<const void> owner, const uint8_t* data, size_t size) {
+    Bank bank;
+    bank.owner = std::move(owner);
+    bank.data = data;
+    bank.size = size;
+    std::lock_guard<std::mutex> lock(mutex_);
+    bank.sequence = ++sequence_;
+    return bank;
+}
+
+void IngestRing::Releaser::operator()(Slot* slot) const {
+    if (auto owner = ring.lock()) {
+        owner->Release(slot);
+    } else {
+        delete slot;
+    }
+}
+
+void IngestRing::Release(Slot* slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --leased_;
+        auto empty = std::find(slots_.begin(), slots_.end(), nullptr);
+        if (empty != slots_.end()) {
+            empty->reset(slot);
+        } else {
+            slots_.emplace_back(slot);
+        }
+    }
+    released_.notify_one();
+}
+
+size_t IngestRing::GetSlotCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+size_t IngestRing::GetLeasedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return leased_;
+}
+
+uint64_t IngestRing::GetDroppedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
@@ -0,0 +1,75 @@
+#include "analysis_pipeline/unpacker_core/utils/mapped_file.h"
+
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& path, bool sequential) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        spdlog::error("MappedFile: Cannot open '{}': {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        spdlog::error("MappedFile: Cannot stat '{}': {}", path, std::strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    const uint8_t* data = nullptr;
+    if (size > 0) {
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            spdlog::error("MappedFile: Cannot map '{}' ({} bytes): {}", path, size, std::strerror(errno));
+            ::close(fd);
+            return nullptr;
+        }
+        data = static_cast<const uint8_t*>(p);
+    }
+    // The mapping keeps the file referenced
+    ::close(fd);
+
+    std::shared_ptr<MappedFile> file(new MappedFile(path, data, size));
+    if (sequential) {
+        file->Advise(0, size, MADV_SEQUENTIAL);
+    }
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+void MappedFile::Prefetch(size_t offset, size_t length) const {
+    Advise(offset, length, MADV_WILLNEED);
+}
+
+void MappedFile::Release(size_t offset, size_t length) const {
+    Advise(offset, length, MADV_DONTNEED);
+}
+
+void MappedFile::Advise(size_t offset, size_t length, int advice) const {
+    if (!data_ || offset >= size_ || length == 0) {
+        return;
+    }
+    length = std::min(length, size_ - offset);
+
+    // madvise needs a page-aligned start; round it down and grow the range to match
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t aligned = offset / page * page;
+    if (::madvise(const_cast<uint8_t*>(data_) + aligned, length + (offset - aligned), advice) != 0) {
+        spdlog::debug("MappedFile: madvise({}) on '{}' failed: {}", advice, path_, std::strerror(errno));
+    }
+}
@@ -0,0 +1,154 @@
+#include "analysis_pipeline/unpacker_core/utils/mapping_cache.h"
+
+#include <spdlog/spdlog.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+// Bumped when the file layout changes; files of another format are ignored
+constexpr int kFileFormat = 1;
+
+} // namespace
+
+MappingCache& MappingCache::Instance() {
+    static MappingCache instance;
+    static const bool from_environment = [] {
+        const char* path = std::getenv("UNPACKER_MAPPING_CACHE");
+        return path && *path && instance.SetFile(path);
+    }();
+    (void)from_environment;
+    return instance;
+}
+
+std::string MappingCache::MakeKey(TClass* cls,
+                                  const std::string& default_endianness,
+                                  const nlohmann::json& field_overrides) {
+    // Version and checksum come last, so IdentityOf() can strip them
+    return std::string(cls->GetName()) + "|" + default_endianness + "|" + field_overrides.dump() +
+           "|v" + std::to_string(cls->GetClassVersion()) + "|" + std::to_string(cls->GetCheckSum());
+}
+
+std::string MappingCache::IdentityOf(const std::string& key) {
+    return key.substr(0, key.rfind("|v"));
+}
+
+std::shared_ptr<const MappingCache::Entry> MappingCache::Find(TClass* cls,
+                                                              const std::string& default_endianness,
+                                                              const nlohmann::json& field_overrides) const {
+    const std::string key = MakeKey(cls, default_endianness, field_overrides);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    return it != entries_.end() ? it->second : nullptr;
+}
+
+void MappingCache::Insert(TClass* cls,
+                          const std::string& default_endianness,
+                          const nlohmann::json& field_overrides,
+                          std::shared_ptr<const Entry> entry) {
+    const std::string key = MakeKey(cls, default_endianness, field_overrides);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = entries_[key];
+    const bool new_mapping = !slot;
+    slot = std::move(entry);
+    if (!new_mapping) {
+        return;
+    }
+
+    // Mappings of older versions of the class are dead once it has changed
+    const std::string identity = IdentityOf(key);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->first != key && IdentityOf(it->first) == identity) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!file_.empty()) {
+        SaveLocked();
+    }
+}
+
+bool MappingCache::SetFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path == file_) {
+        return true;
+    }
+    file_ = path;
+    return LoadLocked(path);
+}
+
+size_t MappingCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void MappingCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+bool MappingCache::LoadLocked(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        spdlog::debug("MappingCache: No cache file '{}' yet; it will be written as classes are reflected", path);
+        return true;
+    }
+
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const nlohmann::json contents = nlohmann::json::from_cbor(bytes, true, false);
+    if (contents.is_discarded() || !contents.is_object() || contents.value("format", 0) != kFileFormat ||
+        !contents.contains("entries") || !contents["entries"].is_object()) {
+        spdlog::warn("MappingCache: Ignoring unreadable cache file '{}'", path);
+        return false;
+    }
+
+    size_t loaded = 0;
+    for (const auto& [key, value] : contents["entries"].items()) {
+        if (entries_.count(key) > 0 || !value.contains("mapping") || !value.contains("size")) {
+            continue;
+        }
+        auto entry = std::make_shared<Entry>();
+        entry->mapping = value["mapping"];
+        entry->total_parsed_size = value["size"].get<size_t>();
+        entries_.emplace(key, std::move(entry));
+        ++loaded;
+    }
+
+    spdlog::debug("MappingCache: Loaded {} mappings from '{}'", loaded, path);
+    return true;
+}
+
+void MappingCache::SaveLocked() const {
+    nlohmann::json contents;
+    contents["format"] = kFileFormat;
+    nlohmann::json& entries = contents["entries"];
+    entries = nlohmann::json::object();
+    for (const auto& [key, entry] : entries_) {
+        entries[key] = {{"mapping", entry->mapping}, {"size", entry->total_parsed_size}};
+    }
+
+    // Write and rename, so concurrent jobs never read a partial file
+    const std::string tmp = file_ + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        const std::vector<uint8_t> bytes = nlohmann::json::to_cbor(contents);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            spdlog::warn("MappingCache: Could not write cache file '{}'", tmp);
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), file_.c_str()) != 0) {
+        spdlog::warn("MappingCache: Could not replace cache file '{}'", file_);
+        std::remove(tmp.c_str());
+    }
+}
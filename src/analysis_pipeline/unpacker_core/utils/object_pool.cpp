@@ -0,0 +1,137 @@
+#include "analysis_pipeline/unpacker_core/utils/object_pool.h"
+#include <spdlog/spdlog.h>
+
+void ObjectPool::Recycler::operator()(TObject* obj) const {
+    if (!obj) {
+        return;
+    }
+    if (auto owner = pool.lock()) {
+        owner->Release(obj);
+    } else {
+        delete obj;
+    }
+}
+
+std::shared_ptr<ObjectPool> ObjectPool::Create(TClass* cls, size_t max_idle) {
+    if (!cls || !cls->InheritsFrom(TObject::Class())) {
+        spdlog::error("ObjectPool: Class '{}' is not a TObject", cls ? cls->GetName() : "<null>");
+        return nullptr;
+    }
+    // TObject need not be the first base, so New()'s address is adjusted by this offset
+    const Int_t offset = cls->GetBaseClassOffset(TObject::Class());
+    if (offset < 0) {
+        spdlog::error("ObjectPool: Cannot locate the TObject base of class '{}'", cls->GetName());
+        return nullptr;
+    }
+    return std::shared_ptr<ObjectPool>(new ObjectPool(cls, static_cast<size_t>(offset), max_idle));
+}
+
+ObjectPool::ObjectPool(TClass* cls, size_t tobject_offset, size_t max_idle)
+    : cls_(cls), tobject_offset_(tobject_offset), max_idle_(max_idle) {}
+
+ObjectPool::~ObjectPool() {
+    for (TObject* obj : idle_) {
+        delete obj;
+    }
+}
+
+ObjectPool::Pointer ObjectPool::Acquire() {
+    TObject* obj = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            obj = idle_.back();
+            idle_.pop_back();
+            ++reused_;
+        }
+    }
+
+    if (!obj) {
+        obj = Construct();
+        if (!obj) {
+            return Pointer(nullptr, Recycler{weak_from_this()});
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++created_;
+    }
+
+    return Pointer(obj, Recycler{weak_from_this()});
+}
+
+void ObjectPool::Reserve(size_t count) {
+    std::vector<TObject*> fresh;
+    size_t missing = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() >= count) {
+            return;
+        }
+        missing = count - idle_.size();
+    }
+
+    // reserve() may round the capacity up, so the loop counts objects itself
+    fresh.reserve(missing);
+    while (fresh.size() < missing) {
+        TObject* obj = Construct();
+        if (!obj) {
+            break;
+        }
+        fresh.push_back(obj);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    created_ += fresh.size();
+    idle_.insert(idle_.end(), fresh.begin(), fresh.end());
+}
+
+void ObjectPool::Release(TObject* obj) {
+    if (!Reset(obj)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < max_idle_) {
+            idle_.push_back(obj);
+            return;
+        }
+    }
+
+    delete obj;
+}
+
+TObject* ObjectPool::Construct() const {
+    void* raw = cls_->New();
+    if (!raw) {
+        spdlog::error("ObjectPool: Failed to construct object of class '{}'", cls_->GetName());
+        return nullptr;
+    }
+    return reinterpret_cast<TObject*>(static_cast<char*>(raw) + tobject_offset_);
+}
+
+bool ObjectPool::Reset(TObject* obj) const {
+    // Same in-place reset TClonesArray uses for its slots; the allocation is kept
+    void* raw = reinterpret_cast<char*>(obj) - tobject_offset_;
+    cls_->Destructor(raw, true);
+    if (!cls_->New(raw)) {
+        spdlog::error("ObjectPool: Failed to re-construct object of class '{}'", cls_->GetName());
+        TObject::operator delete(raw);
+        return false;
+    }
+    return true;
+}
+
+size_t ObjectPool::GetIdleCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+size_t ObjectPool::GetCreatedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return created_;
+}
+
+size_t ObjectPool::GetReusedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reused_;
+}
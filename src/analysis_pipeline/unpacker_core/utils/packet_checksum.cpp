@@ -0,0 +1,301 @@
+#include "analysis_pipeline/unpacker_core/utils/packet_checksum.h"
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UNPACKER_CORE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr bool kHostLittleEndian = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+// ---- CRC ------------------------------------------------------------------------------
+
+struct CrcTables {
+    uint32_t t[8][256];
+};
+
+CrcTables MakeCrcTables(uint32_t reflected_poly) {
+    CrcTables tables;
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            c = (c & 1) ? (c >> 1) ^ reflected_poly : c >> 1;
+        }
+        tables.t[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (int k = 1; k < 8; ++k) {
+            tables.t[k][i] = (tables.t[k - 1][i] >> 8) ^ tables.t[0][tables.t[k - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+const CrcTables& Crc32cTables() {
+    static const CrcTables tables = MakeCrcTables(0x82F63B78u);
+    return tables;
+}
+
+const CrcTables& Crc32Tables() {
+    static const CrcTables tables = MakeCrcTables(0xEDB88320u);
+    return tables;
+}
+
+// Eight table lookups per 8 bytes instead of eight dependent byte steps
+uint32_t CrcSlice8(const CrcTables& tables, const uint8_t* data, size_t size, uint32_t crc) {
+    const auto& t = tables.t;
+    uint32_t c = ~crc;
+    if (kHostLittleEndian) {
+        for (; size >= 8; data += 8, size -= 8) {
+            uint64_t v;
+            std::memcpy(&v, data, 8);
+            v ^= c;
+            c = t[7][v & 0xFF] ^ t[6][(v >> 8) & 0xFF] ^ t[5][(v >> 16) & 0xFF] ^ t[4][(v >> 24) & 0xFF] ^
+                t[3][(v >> 32) & 0xFF] ^ t[2][(v >> 40) & 0xFF] ^ t[1][(v >> 48) & 0xFF] ^ t[0][v >> 56];
+        }
+    }
+    for (; size > 0; ++data, --size) {
+        c = t[0][(c ^ *data) & 0xFF] ^ (c >> 8);
+    }
+    return ~c;
+}
+
+uint32_t Crc32cScalar(const uint8_t* data, size_t size, uint32_t crc) {
+    return CrcSlice8(Crc32cTables(), data, size, crc);
+}
+
+#ifdef UNPACKER_CORE_X86_SIMD
+__attribute__((target("sse4.2")))
+uint32_t Crc32cSse42(const uint8_t* data, size_t size, uint32_t crc) {
+#if defined(__x86_64__)
+    uint64_t c = ~crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        uint64_t v;
+        std::memcpy(&v, data, 8);
+        c = _mm_crc32_u64(c, v);
+    }
+    uint32_t c32 = static_cast<uint32_t>(c);
+#else
+    uint32_t c32 = ~crc;
+#endif
+    for (; size >= 4; data += 4, size -= 4) {
+        uint32_t v;
+        std::memcpy(&v, data, 4);
+        c32 = _mm_crc32_u32(c32, v);
+    }
+    for (; size > 0; ++data, --size) {
+        c32 = _mm_crc32_u8(c32, *data);
+    }
+    return ~c32;
+}
+#endif // UNPACKER_CORE_X86_SIMD
+
+// ---- Ones'-complement sum ------------------------------------------------------------
+//
+// The sum is byte-order independent up to a final swap (RFC 1071), so every kernel adds
+// little endian words and the caller swaps the folded result for big endian data.
+
+uint64_t SumWordsScalar(const uint8_t* data, size_t size, uint64_t sum) {
+    for (; size >= 2; data += 2, size -= 2) {
+        sum += static_cast<uint64_t>(data[0]) | (static_cast<uint64_t>(data[1]) << 8);
+    }
+    if (size) {
+        sum += data[0];
+    }
+    return sum;
+}
+
+#ifdef UNPACKER_CORE_X86_SIMD
+// Words are widened to 32-bit lanes; each block adds at most 2 * 0xFFFF to a lane, so the
+// lanes are drained into the 64-bit total before they can overflow
+constexpr size_t kBlocksPerDrain = 16384;
+
+__attribute__((target("sse2")))
+uint64_t SumWordsSse2(const uint8_t* data, size_t size, uint64_t sum) {
+    const __m128i zero = _mm_setzero_si128();
+    while (size >= 16) {
+        __m128i acc = _mm_setzero_si128();
+        for (size_t blocks = 0; size >= 16 && blocks < kBlocksPerDrain; data += 16, size -= 16, ++blocks) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_unpacklo_epi16(v, zero), _mm_unpackhi_epi16(v, zero)));
+        }
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        for (uint32_t lane : lanes) {
+            sum += lane;
+        }
+    }
+    return SumWordsScalar(data, size, sum);
+}
+
+__attribute__((target("avx2")))
+uint64_t SumWordsAvx2(const uint8_t* data, size_t size, uint64_t sum) {
+    const __m256i zero = _mm256_setzero_si256();
+    while (size >= 32) {
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t blocks = 0; size >= 32 && blocks < kBlocksPerDrain; data += 32, size -= 32, ++blocks) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_unpacklo_epi16(v, zero),
+                                                         _mm256_unpackhi_epi16(v, zero)));
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        for (uint32_t lane : lanes) {
+            sum += lane;
+        }
+    }
+    return SumWordsSse2(data, size, sum);
+}
+#endif // UNPACKER_CORE_X86_SIMD
+
+using Crc32cKernel = uint32_t (*)(const uint8_t* data, size_t size, uint32_t crc);
+using SumKernel = uint64_t (*)(const uint8_t* data, size_t size, uint64_t sum);
+
+struct KernelTable {
+    Crc32cKernel crc32c;
+    const char* crc32c_name;
+    SumKernel sum;
+    const char* sum_name;
+};
+
+KernelTable SelectKernels() {
+    KernelTable table{&Crc32cScalar, "scalar", &SumWordsScalar, "scalar"};
+#ifdef UNPACKER_CORE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        table.crc32c = &Crc32cSse42;
+        table.crc32c_name = "sse4.2";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        table.sum = &SumWordsAvx2;
+        table.sum_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        table.sum = &SumWordsSse2;
+        table.sum_name = "sse2";
+    }
+#endif
+    return table;
+}
+
+const KernelTable& Kernels() {
+    static const KernelTable table = SelectKernels();
+    return table;
+}
+
+// Resolves an offset that counts from the record end when negative
+bool Resolve(int64_t offset, size_t record_length, size_t& out) {
+    if (offset < 0) {
+        if (static_cast<uint64_t>(-offset) > record_length) {
+            return false;
+        }
+        out = record_length - static_cast<size_t>(-offset);
+        return true;
+    }
+    out = static_cast<size_t>(offset);
+    return out <= record_length;
+}
+
+} // namespace
+
+namespace Checksum {
+
+uint32_t Crc32c(const uint8_t* data, size_t size, uint32_t crc) {
+    return Kernels().crc32c(data, size, crc);
+}
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc) {
+    return CrcSlice8(Crc32Tables(), data, size, crc);
+}
+
+uint16_t OnesComplementSum16(const uint8_t* data, size_t size, bool little_endian) {
+    uint64_t sum = Kernels().sum(data, size, 0);
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    const uint16_t folded = static_cast<uint16_t>(sum);
+    return little_endian ? folded : static_cast<uint16_t>((folded >> 8) | (folded << 8));
+}
+
+const char* ActiveSumKernelName() {
+    return Kernels().sum_name;
+}
+
+const char* ActiveCrc32cKernelName() {
+    return Kernels().crc32c_name;
+}
+
+} // namespace Checksum
+
+bool PacketChecksum::FromJson(const nlohmann::json& config, PacketChecksum& checksum) {
+    if (!config.is_object()) {
+        spdlog::error("PacketChecksum: Configuration is not a JSON object");
+        return false;
+    }
+
+    checksum = PacketChecksum();
+    const std::string algorithm = config.value("algorithm", std::string());
+    if (algorithm == "crc32c") {
+        checksum.algorithm = Algorithm::kCrc32c;
+    } else if (algorithm == "crc32") {
+        checksum.algorithm = Algorithm::kCrc32;
+    } else if (algorithm == "ones_complement16") {
+        checksum.algorithm = Algorithm::kOnesComplement16;
+    } else {
+        spdlog::error("PacketChecksum: \"algorithm\" must be \"crc32c\", \"crc32\" or \"ones_complement16\", not '{}'",
+                      algorithm);
+        return false;
+    }
+
+    checksum.offset = config.value("offset", -static_cast<int64_t>(checksum.Size()));
+    checksum.begin = config.value("begin", static_cast<size_t>(0));
+    checksum.has_end = config.contains("end");
+    checksum.end = config.value("end", static_cast<int64_t>(0));
+    checksum.little_endian = config.value("endianness", std::string("little")) == "little";
+
+    if (checksum.offset >= 0 && !checksum.has_end && static_cast<size_t>(checksum.offset) >= checksum.begin &&
+        static_cast<size_t>(checksum.offset) < checksum.begin + checksum.Size()) {
+        spdlog::error("PacketChecksum: The checksum at offset {} lies inside the bytes it covers", checksum.offset);
+        return false;
+    }
+    return true;
+}
+
+bool PacketChecksum::Verify(const uint8_t* record, size_t record_length) const {
+    size_t position;
+    if (!Resolve(offset, record_length, position) || Size() > record_length - position) {
+        return false;
+    }
+
+    size_t covered_end;
+    if (has_end) {
+        if (!Resolve(end, record_length, covered_end)) {
+            return false;
+        }
+    } else {
+        covered_end = (position >= begin) ? position : record_length;
+    }
+    if (begin > covered_end) {
+        return false;
+    }
+
+    const bool swap = little_endian != kHostLittleEndian;
+    const uint8_t* covered = record + begin;
+    const size_t covered_size = covered_end - begin;
+    switch (algorithm) {
+        case Algorithm::kCrc32c:
+            return Checksum::Crc32c(covered, covered_size) == ByteSwap::Load<uint32_t>(record + position, swap);
+        case Algorithm::kCrc32:
+            return Checksum::Crc32(covered, covered_size) == ByteSwap::Load<uint32_t>(record + position, swap);
+        case Algorithm::kOnesComplement16:
+            return static_cast<uint16_t>(~Checksum::OnesComplementSum16(covered, covered_size, little_endian)) ==
+                   ByteSwap::Load<uint16_t>(record + position, swap);
+    }
+    return false;
+}
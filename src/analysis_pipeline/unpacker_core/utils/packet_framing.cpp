@@ -0,0 +1,319 @@
+#include "analysis_pipeline/unpacker_core/utils/packet_framing.h"
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UNPACKER_CORE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr bool kHostLittleEndian = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+using FindKernel = size_t (*)(const uint8_t* data, size_t data_size, size_t from,
+                              const uint8_t* magic, size_t magic_size);
+
+inline bool MatchesMiddle(const uint8_t* candidate, const uint8_t* magic, size_t magic_size) {
+    return magic_size <= 2 || std::memcmp(candidate + 1, magic + 1, magic_size - 2) == 0;
+}
+
+size_t FindMagicScalar(const uint8_t* data, size_t data_size, size_t from,
+                       const uint8_t* magic, size_t magic_size) {
+    while (from + magic_size <= data_size) {
+        const void* hit = std::memchr(data + from, magic[0], data_size - magic_size + 1 - from);
+        if (!hit) {
+            break;
+        }
+        const size_t pos = static_cast<size_t>(static_cast<const uint8_t*>(hit) - data);
+        if (std::memcmp(data + pos, magic, magic_size) == 0) {
+            return pos;
+        }
+        from = pos + 1;
+    }
+    return data_size;
+}
+
+#ifdef UNPACKER_CORE_X86_SIMD
+
+// Positions whose first and last bytes both match are candidates; a short magic rarely
+// produces more than one per block, so the memcmp confirming them is cheap
+__attribute__((target("sse2")))
+size_t FindMagicSse2(const uint8_t* data, size_t data_size, size_t from,
+                     const uint8_t* magic, size_t magic_size) {
+    const __m128i first = _mm_set1_epi8(static_cast<char>(magic[0]));
+    const __m128i last = _mm_set1_epi8(static_cast<char>(magic[magic_size - 1]));
+
+    size_t i = from;
+    for (; i + magic_size - 1 + 16 <= data_size; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + magic_size - 1));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask) {
+            const size_t pos = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (MatchesMiddle(data + pos, magic, magic_size)) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return FindMagicScalar(data, data_size, i, magic, magic_size);
+}
+
+__attribute__((target("avx2")))
+size_t FindMagicAvx2(const uint8_t* data, size_t data_size, size_t from,
+                     const uint8_t* magic, size_t magic_size) {
+    const __m256i first = _mm256_set1_epi8(static_cast<char>(magic[0]));
+    const __m256i last = _mm256_set1_epi8(static_cast<char>(magic[magic_size - 1]));
+
+    size_t i = from;
+    for (; i + magic_size - 1 + 32 <= data_size; i += 32) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + magic_size - 1));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while (mask) {
+            const size_t pos = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (MatchesMiddle(data + pos, magic, magic_size)) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return FindMagicSse2(data, data_size, i, magic, magic_size);
+}
+
+#endif // UNPACKER_CORE_X86_SIMD
+
+struct FindKernelEntry {
+    FindKernel find;
+    const char* name;
+};
+
+FindKernelEntry SelectFindKernel() {
+#ifdef UNPACKER_CORE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {&FindMagicAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {&FindMagicSse2, "sse2"};
+    }
+#endif
+    return {&FindMagicScalar, "scalar"};
+}
+
+const FindKernelEntry& Kernel() {
+    static const FindKernelEntry entry = SelectFindKernel();
+    return entry;
+}
+
+bool ParseMagic(const nlohmann::json& value, std::vector<uint8_t>& magic) {
+    magic.clear();
+    if (value.is_array()) {
+        for (const auto& byte : value) {
+            if (!byte.is_number_unsigned() || byte.get<uint64_t>() > 0xFF) {
+                return false;
+            }
+            magic.push_back(static_cast<uint8_t>(byte.get<uint64_t>()));
+        }
+        return true;
+    }
+    if (value.is_string()) {
+        // Hex digits in stream order, e.g. "0xAA55" or "AA 55"
+        std::string hex = value.get<std::string>();
+        if (hex.compare(0, 2, "0x") == 0 || hex.compare(0, 2, "0X") == 0) {
+            hex = hex.substr(2);
+        }
+        hex.erase(std::remove(hex.begin(), hex.end(), ' '), hex.end());
+        if (hex.empty() || hex.size() % 2 != 0 ||
+            hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+            return false;
+        }
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            magic.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+        }
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool PacketFraming::FromJson(const nlohmann::json& config, PacketFraming& framing) {
+    if (!config.is_object()) {
+        spdlog::error("PacketFraming: Configuration is not a JSON object");
+        return false;
+    }
+
+    framing = PacketFraming();
+    if (config.contains("magic") && !ParseMagic(config["magic"], framing.magic)) {
+        spdlog::error("PacketFraming: \"magic\" must be a hex string or an array of bytes");
+        return false;
+    }
+    framing.magic_offset = config.value("magic_offset", static_cast<size_t>(0));
+    framing.stride = config.value("stride", static_cast<size_t>(0));
+    framing.length_offset = config.value("length_offset", static_cast<size_t>(0));
+    framing.length_size = config.value("length_size", static_cast<size_t>(0));
+    framing.length_little_endian = config.value("length_endianness", std::string("little")) == "little";
+    framing.length_unit = config.value("length_unit", static_cast<size_t>(1));
+    framing.length_adjust = config.value("length_adjust", static_cast<int64_t>(0));
+    framing.resync = config.value("resync", true);
+
+    if (framing.length_size == 0 && framing.stride == 0) {
+        spdlog::error("PacketFraming: Either \"stride\" or \"length_size\" must be set");
+        return false;
+    }
+    if (framing.length_size != 0 && framing.length_size != 1 && framing.length_size != 2 &&
+        framing.length_size != 4 && framing.length_size != 8) {
+        spdlog::error("PacketFraming: \"length_size\" must be 1, 2, 4 or 8, got {}", framing.length_size);
+        return false;
+    }
+    if (framing.length_unit == 0) {
+        spdlog::error("PacketFraming: \"length_unit\" must be positive");
+        return false;
+    }
+    if (framing.length_size == 0 && framing.stride < framing.HeaderSize()) {
+        spdlog::error("PacketFraming: Stride {} is shorter than the magic at offset {}", framing.stride, framing.magic_offset);
+        return false;
+    }
+    if (framing.resync && framing.magic.empty()) {
+        // Nothing to search for; a malformed record simply ends the scan
+        framing.resync = false;
+    }
+    return true;
+}
+
+size_t PacketFraming::HeaderSize() const {
+    size_t header = magic.empty() ? 0 : magic_offset + magic.size();
+    if (length_size) {
+        header = std::max(header, length_offset + length_size);
+    }
+    return header;
+}
+
+size_t PacketFraming::RecordLength(const uint8_t* record, size_t available) const {
+    if (length_size == 0) {
+        return stride;
+    }
+    if (length_offset + length_size > available) {
+        return 0;
+    }
+
+    const uint8_t* src = record + length_offset;
+    const bool swap = (length_little_endian != kHostLittleEndian);
+    uint64_t value;
+    switch (length_size) {
+        case 1: value = *src; break;
+        case 2: value = ByteSwap::Load<uint16_t>(src, swap); break;
+        case 4: value = ByteSwap::Load<uint32_t>(src, swap); break;
+        default: value = ByteSwap::Load<uint64_t>(src, swap); break;
+    }
+
+    if (value > std::numeric_limits<uint32_t>::max() / length_unit) {
+        return 0;
+    }
+    const int64_t length = static_cast<int64_t>(value * length_unit) + length_adjust;
+    if (length <= 0 || static_cast<uint64_t>(length) < HeaderSize() ||
+        static_cast<uint64_t>(length) > std::numeric_limits<uint32_t>::max()) {
+        return 0;
+    }
+    return static_cast<size_t>(length);
+}
+
+size_t PacketFraming::HeaderLength(const uint8_t* record) const {
+    if (!magic.empty() && std::memcmp(record + magic_offset, magic.data(), magic.size()) != 0) {
+        return 0;
+    }
+    return RecordLength(record, HeaderSize());
+}
+
+bool PacketFraming::IsTruncatedRecord(const uint8_t* record, size_t available) const {
+    if (available == 0) {
+        return false;
+    }
+    if (available < HeaderSize()) {
+        for (size_t i = 0; i < magic.size() && magic_offset + i < available; ++i) {
+            if (record[magic_offset + i] != magic[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    const size_t length = HeaderLength(record);
+    return length > available;
+}
+
+PacketScanner::Result PacketScanner::Scan(const uint8_t* data,
+                                          size_t data_size,
+                                          size_t start_offset,
+                                          const PacketFraming& framing,
+                                          std::vector<uint64_t>& offsets,
+                                          std::vector<uint32_t>& lengths) {
+    Result result;
+    result.end_offset = start_offset;
+    if (!data || start_offset >= data_size) {
+        return result;
+    }
+
+    const uint8_t* magic = framing.magic.data();
+    const size_t magic_size = framing.magic.size();
+    const size_t header_size = framing.HeaderSize();
+
+    size_t pos = start_offset;
+    while (pos < data_size && data_size - pos >= header_size) {
+        const uint8_t* record = data + pos;
+        size_t length = 0;
+        const bool tagged = magic_size == 0 || std::memcmp(record + framing.magic_offset, magic, magic_size) == 0;
+        if (tagged) {
+            length = framing.RecordLength(record, data_size - pos);
+        }
+
+        if (length == 0) {
+            if (!framing.resync) {
+                break;
+            }
+            // Next magic that leaves room for the bytes in front of it
+            const size_t next = FindMagic(data, data_size, pos + 1 + framing.magic_offset, magic, magic_size);
+            if (next == data_size) {
+                break;
+            }
+            result.skipped_bytes += next - framing.magic_offset - pos;
+            pos = next - framing.magic_offset;
+            continue;
+        }
+
+        if (length > data_size - pos) {
+            break;  // trailing record continues in the next bank
+        }
+
+        offsets.push_back(pos);
+        lengths.push_back(static_cast<uint32_t>(length));
+        pos += length;
+    }
+
+    result.end_offset = pos;
+    return result;
+}
+
+size_t PacketScanner::FindMagic(const uint8_t* data,
+                                size_t data_size,
+                                size_t from,
+                                const uint8_t* magic,
+                                size_t magic_size) {
+    if (magic_size == 0 || from > data_size || data_size - from < magic_size) {
+        return data_size;
+    }
+    return Kernel().find(data, data_size, from, magic, magic_size);
+}
+
+const char* PacketScanner::ActiveKernelName() {
+    return Kernel().name;
+}
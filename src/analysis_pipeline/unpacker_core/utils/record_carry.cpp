@@ -0,0 +1,60 @@
+#include "analysis_pipeline/unpacker_core/utils/record_carry.h"
+
+#include <algorithm>
+
+RecordCarry::RecordCarry(size_t max_record_bytes) : max_record_bytes_(max_record_bytes) {}
+
+bool RecordCarry::Stash(const uint8_t* bank, size_t bank_size, size_t offset) {
+    Clear();
+    if (!bank || offset >= bank_size || bank_size - offset > max_record_bytes_) {
+        return false;
+    }
+    bytes_.assign(bank + offset, bank + bank_size);
+    return true;
+}
+
+void RecordCarry::Append(const uint8_t* bank, size_t bank_size, size_t& consumed, size_t target) {
+    if (bytes_.size() >= target) {
+        return;
+    }
+    const size_t take = std::min(target - bytes_.size(), bank_size - consumed);
+    bytes_.insert(bytes_.end(), bank + consumed, bank + consumed + take);
+    consumed += take;
+}
+
+RecordCarry::Status RecordCarry::Complete(const uint8_t* bank,
+                                          size_t bank_size,
+                                          size_t header_size,
+                                          const LengthFn& length_of,
+                                          size_t& consumed) {
+    consumed = 0;
+    if (bytes_.empty()) {
+        return Status::kEmpty;
+    }
+    if (!bank) {
+        bank_size = 0;
+    }
+
+    if (record_length_ == 0) {
+        Append(bank, bank_size, consumed, header_size);
+        if (bytes_.size() < header_size) {
+            return Status::kIncomplete;
+        }
+        // A record never ends inside its own header, and the stashed head was shorter than it
+        record_length_ = length_of(bytes_.data());
+        if (record_length_ < std::max<size_t>(header_size, 1) || record_length_ < bytes_.size() ||
+            record_length_ > max_record_bytes_) {
+            Clear();
+            consumed = 0;
+            return Status::kMalformed;
+        }
+    }
+
+    Append(bank, bank_size, consumed, record_length_);
+    return bytes_.size() == record_length_ ? Status::kComplete : Status::kIncomplete;
+}
+
+void RecordCarry::Clear() {
+    bytes_.clear();
+    record_length_ = 0;
+}
@@ -0,0 +1,194 @@
+#include "analysis_pipeline/unpacker_core/utils/record_dispatch.h"
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+#include "analysis_pipeline/unpacker_core/utils/reflection_based_parser.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+constexpr bool kHostLittleEndian = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+// Tag values and masks are numbers or strings such as "0xF0"
+bool ParseInteger(const nlohmann::json& value, uint64_t& out) {
+    if (value.is_number_unsigned()) {
+        out = value.get<uint64_t>();
+        return true;
+    }
+    if (value.is_string()) {
+        try {
+            size_t used = 0;
+            const std::string text = value.get<std::string>();
+            out = std::stoull(text, &used, 0);
+            return used == text.size();
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool RecordDispatchTable::FromJson(const nlohmann::json& config, RecordDispatchTable& table) {
+    table = RecordDispatchTable();
+
+    if (!config.is_object() || !config.contains("types") || !config["types"].is_array() || config["types"].empty()) {
+        spdlog::error("RecordDispatchTable: Configuration needs a non-empty \"types\" array");
+        return false;
+    }
+
+    if (config.contains("tag")) {
+        const auto& tag = config["tag"];
+        table.tag_offset_ = tag.value("offset", static_cast<size_t>(0));
+        table.tag_size_ = tag.value("size", static_cast<size_t>(1));
+        table.tag_swap_ = (tag.value("endianness", std::string("little")) == "little") != kHostLittleEndian;
+        table.tag_shift_ = tag.value("shift", 0u);
+        if (tag.contains("mask") && !ParseInteger(tag["mask"], table.tag_mask_)) {
+            spdlog::error("RecordDispatchTable: \"mask\" must be an unsigned integer or a hex string");
+            return false;
+        }
+    }
+    if (table.tag_size_ != 1 && table.tag_size_ != 2 && table.tag_size_ != 4 && table.tag_size_ != 8) {
+        spdlog::error("RecordDispatchTable: Tag size must be 1, 2, 4 or 8 bytes, not {}", table.tag_size_);
+        return false;
+    }
+    if (table.tag_shift_ >= 64) {
+        spdlog::error("RecordDispatchTable: Tag shift {} is out of range", table.tag_shift_);
+        return false;
+    }
+
+    const std::string on_unknown = config.value("on_unknown", std::string("stop"));
+    if (on_unknown != "stop" && on_unknown != "skip") {
+        spdlog::error("RecordDispatchTable: \"on_unknown\" must be \"stop\" or \"skip\", not '{}'", on_unknown);
+        return false;
+    }
+    table.skip_unknown_ = (on_unknown == "skip");
+    table.skip_bytes_ = std::max<size_t>(1, config.value("skip_bytes", static_cast<size_t>(1)));
+
+    uint64_t max_tag = 0;
+    for (const auto& entry : config["types"]) {
+        Type type;
+        if (!entry.contains("tag") || !ParseInteger(entry["tag"], type.tag)) {
+            spdlog::error("RecordDispatchTable: Type entry without a valid \"tag\": {}", entry.dump());
+            return false;
+        }
+        const std::string class_name = entry.value("class", std::string());
+        type.cls = TClass::GetClass(class_name.c_str());
+        if (!type.cls) {
+            spdlog::error("RecordDispatchTable: Class '{}' for tag {} not found", class_name, type.tag);
+            return false;
+        }
+
+        if (entry.contains("mapping")) {
+            type.plan = CompiledParsePlan::Compile(entry["mapping"], type.cls);
+        } else {
+            ReflectionBasedParser parser(class_name, entry.value("endianness", std::string("little")),
+                                         entry.value("field_overrides", nlohmann::json::object()));
+            type.plan = parser.GetPlan();
+        }
+        if (!type.plan) {
+            spdlog::error("RecordDispatchTable: No field mapping for class '{}' (tag {})", class_name, type.tag);
+            return false;
+        }
+
+        type.record_size = entry.value("record_size", type.plan->GetRecordExtent());
+        if (type.record_size < std::max(type.plan->GetRecordExtent(), table.TagEnd()) || type.record_size == 0) {
+            spdlog::error("RecordDispatchTable: record_size {} of class '{}' is smaller than its fields or tag",
+                          type.record_size, class_name);
+            return false;
+        }
+        type.product_name = entry.value("product_name", class_name);
+
+        for (const Type& other : table.types_) {
+            if (other.tag == type.tag) {
+                spdlog::error("RecordDispatchTable: Tag {} is mapped twice", type.tag);
+                return false;
+            }
+            // Each type is published as its own product, so two sharing a name would
+            // overwrite each other
+            if (other.product_name == type.product_name) {
+                spdlog::error("RecordDispatchTable: Tags {} and {} both publish product '{}'; give each a "
+                              "distinct \"product_name\"", other.tag, type.tag, type.product_name);
+                return false;
+            }
+        }
+        max_tag = std::max(max_tag, type.tag);
+        table.types_.push_back(std::move(type));
+    }
+
+    if (max_tag <= kMaxDenseTag) {
+        table.dense_.assign(max_tag + 1, -1);
+        for (size_t i = 0; i < table.types_.size(); ++i) {
+            table.dense_[table.types_[i].tag] = static_cast<int>(i);
+        }
+    } else {
+        for (size_t i = 0; i < table.types_.size(); ++i) {
+            table.sparse_.emplace(table.types_[i].tag, static_cast<int>(i));
+        }
+    }
+    return true;
+}
+
+uint64_t RecordDispatchTable::ReadTag(const uint8_t* record) const {
+    const uint8_t* src = record + tag_offset_;
+    uint64_t value;
+    switch (tag_size_) {
+        case 1: value = *src; break;
+        case 2: value = ByteSwap::Load<uint16_t>(src, tag_swap_); break;
+        case 4: value = ByteSwap::Load<uint32_t>(src, tag_swap_); break;
+        default: value = ByteSwap::Load<uint64_t>(src, tag_swap_); break;
+    }
+    return (value & tag_mask_) >> tag_shift_;
+}
+
+RecordDispatchTable::Result RecordDispatchTable::Decode(const uint8_t* data,
+                                                        size_t data_size,
+                                                        size_t start_offset,
+                                                        const std::vector<TClonesArray*>& outputs,
+                                                        bool check_fields) const {
+    Result result;
+    size_t pos = start_offset;
+
+    while (pos < data_size && TagEnd() <= data_size - pos) {
+        const int index = Find(ReadTag(data + pos));
+        if (index < 0) {
+            if (!skip_unknown_) {
+                result.unknown_tag = true;
+                break;
+            }
+            ++result.skipped_records;
+            pos += skip_bytes_;
+            continue;
+        }
+
+        const Type& type = types_[static_cast<size_t>(index)];
+        if (type.record_size > data_size - pos) {
+            break;  // truncated; the rest of the record may arrive with the next bank
+        }
+
+        TClonesArray& out = *outputs[static_cast<size_t>(index)];
+        const Int_t slot = out.GetEntriesFast();
+        TObject* obj = out.ConstructedAt(slot, "C");
+
+        // The record fits, so only the end-relative and variable-length fields need checks
+        size_t used = 0;
+        const bool ok = check_fields ? type.plan->ExecuteChecked(data, data_size, pos, obj, &used)
+                        : type.plan->CheckRange(data_size, pos, pos)
+                            ? type.plan->ExecuteTrusted(data, data_size, pos, obj, &used)
+                            : type.plan->Execute(data, data_size, pos, obj, &used);
+        if (!ok) {
+            out.RemoveAt(slot);
+            result.failed = &type;
+            break;
+        }
+
+        ++result.records;
+        pos += std::max(type.record_size, used);
+    }
+
+    result.end_offset = std::min(pos, data_size);
+    return result;
+}
@@ -0,0 +1,415 @@
+#include "analysis_pipeline/unpacker_core/utils/record_predicate.h"
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+// Recursive descent over the expression, building nodes bottom-up
+class RecordPredicate::Parser {
+public:
+    Parser(RecordPredicate& predicate, const CompiledParsePlan& plan, const std::string& text)
+        : p_(predicate), plan_(plan), text_(text) {}
+
+    bool Parse() {
+        const int root = ParseOr();
+        SkipSpace();
+        if (root < 0 || pos_ != text_.size()) {
+            if (error_.empty()) {
+                error_ = "unexpected '" + text_.substr(pos_, 16) + "'";
+            }
+            return false;
+        }
+        p_.root_ = root;
+        return true;
+    }
+
+    const std::string& Error() const { return error_; }
+    size_t Position() const { return pos_; }
+
+private:
+    void SkipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    bool Accept(const char* token) {
+        SkipSpace();
+        const size_t n = std::strlen(token);
+        if (text_.compare(pos_, n, token) != 0) {
+            return false;
+        }
+        // "&" must not match the first half of "&&"
+        if (n == 1 && token[0] == '&' && pos_ + 1 < text_.size() && text_[pos_ + 1] == '&') {
+            return false;
+        }
+        pos_ += n;
+        return true;
+    }
+
+    int Add(Node node) {
+        p_.nodes_.push_back(std::move(node));
+        return static_cast<int>(p_.nodes_.size() - 1);
+    }
+
+    int Binary(Op op, int lhs, int rhs) {
+        if (lhs < 0 || rhs < 0) {
+            return -1;
+        }
+        Node node;
+        node.op = op;
+        node.lhs = lhs;
+        node.rhs = rhs;
+        return Add(node);
+    }
+
+    int ParseOr() {
+        int lhs = ParseAnd();
+        while (lhs >= 0 && Accept("||")) {
+            lhs = Binary(Op::kOr, lhs, ParseAnd());
+        }
+        return lhs;
+    }
+
+    int ParseAnd() {
+        int lhs = ParseNot();
+        while (lhs >= 0 && Accept("&&")) {
+            lhs = Binary(Op::kAnd, lhs, ParseNot());
+        }
+        return lhs;
+    }
+
+    int ParseNot() {
+        if (Accept("!")) {
+            if (text_.compare(pos_, 1, "=") == 0) {
+                error_ = "unexpected '!='";
+                return -1;
+            }
+            const int operand = ParseNot();
+            if (operand < 0) {
+                return -1;
+            }
+            Node node;
+            node.op = Op::kNot;
+            node.lhs = operand;
+            return Add(node);
+        }
+        return ParseComparison();
+    }
+
+    int ParseComparison() {
+        const int lhs = ParseBitAnd();
+        if (lhs < 0) {
+            return -1;
+        }
+        static const std::pair<const char*, Op> kOps[] = {
+            {"==", Op::kEq}, {"!=", Op::kNe}, {"<=", Op::kLe}, {">=", Op::kGe}, {"<", Op::kLt}, {">", Op::kGt}};
+        for (const auto& [token, op] : kOps) {
+            if (Accept(token)) {
+                return Binary(op, lhs, ParseBitAnd());
+            }
+        }
+        return lhs;
+    }
+
+    int ParseBitAnd() {
+        int lhs = ParsePrimary();
+        while (lhs >= 0 && Accept("&")) {
+            const int rhs = ParsePrimary();
+            if (rhs >= 0 && (KindOf(lhs) == Kind::kFloat || KindOf(rhs) == Kind::kFloat)) {
+                error_ = "'&' needs integer operands";
+                return -1;
+            }
+            lhs = Binary(Op::kBitAnd, lhs, rhs);
+        }
+        return lhs;
+    }
+
+    int ParsePrimary() {
+        SkipSpace();
+        if (Accept("(")) {
+            const int inner = ParseOr();
+            if (inner < 0 || !Accept(")")) {
+                if (error_.empty()) {
+                    error_ = "missing ')'";
+                }
+                return -1;
+            }
+            return inner;
+        }
+        if (pos_ < text_.size() &&
+            (std::isdigit(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '-' || text_[pos_] == '.')) {
+            return ParseNumber();
+        }
+        if (pos_ < text_.size() && (std::isalpha(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) {
+            return ParseField();
+        }
+        error_ = pos_ < text_.size() ? "unexpected '" + text_.substr(pos_, 16) + "'" : "unexpected end of expression";
+        return -1;
+    }
+
+    int ParseNumber() {
+        const char* start = text_.c_str() + pos_;
+        char* end = nullptr;
+        Node node;
+        const size_t token = std::strcspn(start, " \t\n()&|!=<>");
+        const std::string literal(start, token);
+        const bool hex = literal.find("0x") != std::string::npos || literal.find("0X") != std::string::npos;
+        if (!hex && literal.find_first_of(".eE") != std::string::npos) {
+            node.constant.kind = Kind::kFloat;
+            node.constant.f = std::strtod(start, &end);
+        } else if (literal[0] == '-') {
+            node.constant.bits = static_cast<uint64_t>(std::strtoll(start, &end, 0));
+        } else {
+            // Non-negative literals are unsigned, so constants up to 2^64-1 keep their value
+            node.constant.kind = Kind::kUnsigned;
+            node.constant.bits = std::strtoull(start, &end, 0);
+        }
+        if (end != start + token) {
+            error_ = "bad number '" + literal + "'";
+            return -1;
+        }
+        pos_ += token;
+        return Add(node);
+    }
+
+    int ParseField() {
+        const size_t start = pos_;
+        while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) {
+            ++pos_;
+        }
+        const std::string name = text_.substr(start, pos_ - start);
+
+        size_t element = 0;
+        bool indexed = false;
+        if (Accept("[")) {
+            SkipSpace();
+            char* end = nullptr;
+            element = std::strtoull(text_.c_str() + pos_, &end, 0);
+            if (end == text_.c_str() + pos_) {
+                error_ = "bad index for field '" + name + "'";
+                return -1;
+            }
+            pos_ = static_cast<size_t>(end - text_.c_str());
+            if (!Accept("]")) {
+                error_ = "missing ']' after index of field '" + name + "'";
+                return -1;
+            }
+            indexed = true;
+        }
+
+        const size_t index = plan_.FindField(name);
+        if (index == CompiledParsePlan::kNoField) {
+            error_ = "no mapped field '" + name + "'";
+            return -1;
+        }
+        const CompiledParsePlan::FieldOp& op = plan_.GetFields()[index];
+        if (op.dynamic || op.handler || (!op.kernel && !op.bit_width)) {
+            error_ = "field '" + name + "' cannot be read in place (vector, placed after one, or custom type)";
+            return -1;
+        }
+        if (element >= op.count || (op.count > 1 && !indexed)) {
+            error_ = op.count > 1 ? "array field '" + name + "' needs an index below " + std::to_string(op.count)
+                                  : "field '" + name + "' is not an array";
+            return -1;
+        }
+
+        Node node;
+        node.op = Op::kField;
+        FieldLoad& load = node.field;
+        load.kind = op.value_kind;
+        load.element_size = op.element_size;
+        load.swap = op.swap;
+        if (op.bit_width) {
+            load.bit_field = true;
+            load.bits = op.bits;
+            load.bit_offset = op.bit_offset + element * op.bit_width;
+            load.bit_width = op.bit_width;
+            load.big_endian = !op.little_endian;
+            load.sign_extend = op.sign_extend;
+            load.kind = op.sign_extend ? Kind::kSigned : Kind::kUnsigned;
+            load.source_offset = op.source_offset;
+            load.size = op.size;
+        } else {
+            load.source_offset = op.source_offset + static_cast<int64_t>(element * op.element_size);
+            load.size = op.element_size;
+        }
+        if (load.kind == Kind::kFloat && load.element_size != 4 && load.element_size != 8) {
+            error_ = "unsupported floating point width for field '" + name + "'";
+            return -1;
+        }
+
+        if (load.source_offset >= 0) {
+            p_.extent_ = std::max(p_.extent_, static_cast<size_t>(load.source_offset) + load.size);
+        } else {
+            if (load.size > static_cast<size_t>(-load.source_offset)) {
+                error_ = "end-relative field '" + name + "' extends past the buffer end";
+                return -1;
+            }
+            p_.end_extent_ = std::max(p_.end_extent_, static_cast<size_t>(-load.source_offset));
+        }
+        return Add(node);
+    }
+
+    // Kind of value a node evaluates to; mirrors Eval()
+    Kind KindOf(int node) const {
+        const Node& n = p_.nodes_[static_cast<size_t>(node)];
+        switch (n.op) {
+            case Op::kConst: return n.constant.kind;
+            case Op::kField: return n.field.kind;
+            case Op::kBitAnd:
+                return KindOf(n.lhs) == Kind::kUnsigned || KindOf(n.rhs) == Kind::kUnsigned ? Kind::kUnsigned
+                                                                                             : Kind::kSigned;
+            default: return Kind::kSigned;  // comparisons and logic yield 0 or 1
+        }
+    }
+
+    RecordPredicate& p_;
+    const CompiledParsePlan& plan_;
+    const std::string& text_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+std::shared_ptr<const RecordPredicate> RecordPredicate::Compile(const std::string& expression,
+                                                                const CompiledParsePlan& plan) {
+    std::shared_ptr<RecordPredicate> predicate(new RecordPredicate());
+    predicate->expression_ = expression;
+
+    Parser parser(*predicate, plan, expression);
+    if (!parser.Parse()) {
+        spdlog::error("RecordPredicate: Cannot compile selection '{}' for class '{}' at position {}: {}",
+                      expression, plan.GetClass()->GetName(), parser.Position(), parser.Error());
+        return nullptr;
+    }
+    return predicate;
+}
+
+bool RecordPredicate::Matches(const uint8_t* buffer, size_t buffer_size, size_t start_offset) const {
+    if (start_offset > buffer_size || extent_ > buffer_size - start_offset || end_extent_ > buffer_size) {
+        return true;
+    }
+    return Eval(root_, buffer + start_offset, buffer + buffer_size).Truthy();
+}
+
+RecordPredicate::Value RecordPredicate::Load(const FieldLoad& field, const uint8_t* src) {
+    Value value;
+    if (field.bit_field) {
+        // Scalar bit fields carry a precomputed spec; packed arrays are unpacked one sample
+        uint64_t bits = 0;
+        if (field.bits.word_size) {
+            bits = BitUnpack::Extract(field.bits, src);
+        } else {
+            BitUnpack::UnpackArray(&bits, sizeof(bits), src, field.bit_offset, field.bit_width, 1,
+                                   field.big_endian, field.sign_extend);
+        }
+        value.kind = field.kind;
+        value.bits = bits;
+        return value;
+    }
+
+    value.kind = field.kind;
+    const bool is_signed = field.kind == Kind::kSigned;
+    switch (field.element_size) {
+        case 1:
+            value.bits = is_signed ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(*src))) : *src;
+            break;
+        case 2: {
+            const uint16_t raw = ByteSwap::Load<uint16_t>(src, field.swap);
+            value.bits = is_signed ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(raw))) : raw;
+            break;
+        }
+        case 4: {
+            const uint32_t raw = ByteSwap::Load<uint32_t>(src, field.swap);
+            if (field.kind == Kind::kFloat) {
+                float f;
+                std::memcpy(&f, &raw, sizeof(f));
+                value.f = f;
+            } else {
+                value.bits = is_signed ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(raw))) : raw;
+            }
+            break;
+        }
+        default: {
+            const uint64_t raw = ByteSwap::Load<uint64_t>(src, field.swap);
+            if (field.kind == Kind::kFloat) {
+                std::memcpy(&value.f, &raw, sizeof(value.f));
+            } else {
+                value.bits = raw;
+            }
+            break;
+        }
+    }
+    return value;
+}
+
+int RecordPredicate::Compare(const Value& lhs, const Value& rhs) {
+    if (lhs.kind == Kind::kFloat || rhs.kind == Kind::kFloat) {
+        const double a = lhs.AsDouble();
+        const double b = rhs.AsDouble();
+        return (a < b) ? -1 : (a > b) ? 1 : (a == b) ? 0 : 2;
+    }
+    if (lhs.kind == Kind::kSigned && rhs.kind == Kind::kSigned) {
+        const int64_t a = lhs.Signed();
+        const int64_t b = rhs.Signed();
+        return (a < b) ? -1 : (a > b) ? 1 : 0;
+    }
+    // At least one side is unsigned; a negative signed value is below any of them
+    if (lhs.kind == Kind::kSigned && lhs.Signed() < 0) {
+        return -1;
+    }
+    if (rhs.kind == Kind::kSigned && rhs.Signed() < 0) {
+        return 1;
+    }
+    return (lhs.bits < rhs.bits) ? -1 : (lhs.bits > rhs.bits) ? 1 : 0;
+}
+
+RecordPredicate::Value RecordPredicate::Eval(int index, const uint8_t* record, const uint8_t* buffer_end) const {
+    const Node& node = nodes_[static_cast<size_t>(index)];
+    Value result;
+    switch (node.op) {
+        case Op::kConst:
+            return node.constant;
+        case Op::kField: {
+            const uint8_t* src = node.field.source_offset >= 0 ? record + node.field.source_offset
+                                                               : buffer_end + node.field.source_offset;
+            return Load(node.field, src);
+        }
+        case Op::kNot:
+            result.bits = !Eval(node.lhs, record, buffer_end).Truthy();
+            return result;
+        case Op::kAnd:
+            result.bits = Eval(node.lhs, record, buffer_end).Truthy() && Eval(node.rhs, record, buffer_end).Truthy();
+            return result;
+        case Op::kOr:
+            result.bits = Eval(node.lhs, record, buffer_end).Truthy() || Eval(node.rhs, record, buffer_end).Truthy();
+            return result;
+        default:
+            break;
+    }
+
+    const Value lhs = Eval(node.lhs, record, buffer_end);
+    const Value rhs = Eval(node.rhs, record, buffer_end);
+    if (node.op == Op::kBitAnd) {
+        // Operands are integers; the parser rejects '&' on anything of float kind
+        result.kind = lhs.kind == Kind::kUnsigned || rhs.kind == Kind::kUnsigned ? Kind::kUnsigned : Kind::kSigned;
+        result.bits = lhs.bits & rhs.bits;
+        return result;
+    }
+
+    const int cmp = Compare(lhs, rhs);
+    switch (node.op) {
+        case Op::kEq: result.bits = cmp == 0; break;
+        case Op::kNe: result.bits = cmp != 0; break;
+        case Op::kLt: result.bits = cmp == -1; break;
+        case Op::kLe: result.bits = cmp == -1 || cmp == 0; break;
+        case Op::kGt: result.bits = cmp == 1; break;
+        case Op::kGe: result.bits = cmp == 1 || cmp == 0; break;
+        default: break;
+    }
+    return result;
+}
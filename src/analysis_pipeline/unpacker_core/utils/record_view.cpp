@@ -0,0 +1,65 @@
+#include "analysis_pipeline/unpacker_core/utils/record_view.h"
+#include <spdlog/spdlog.h>
+
+bool RecordView::Materialize(TObject* obj) const {
+    if (!plan_ || !buffer_ || !obj) {
+        spdlog::error("RecordView: Cannot materialize an empty view or into a null object");
+        return false;
+    }
+    return plan_->Execute(buffer_, buffer_size_, start_offset_, obj);
+}
+
+const uint8_t* RecordView::FieldAddress(const CompiledParsePlan::FieldOp& field) const {
+    size_t abs_offset;
+    if (field.source_offset >= 0) {
+        abs_offset = start_offset_ + static_cast<size_t>(field.source_offset);
+    } else {
+        if (static_cast<size_t>(-field.source_offset) > buffer_size_) {
+            return nullptr;
+        }
+        abs_offset = buffer_size_ + field.source_offset;
+    }
+
+    if (abs_offset > buffer_size_ || field.size > buffer_size_ - abs_offset) {
+        return nullptr;
+    }
+    return buffer_ + abs_offset;
+}
+
+const uint8_t* RecordView::ElementAddress(size_t field_index, size_t element, size_t width) const {
+    if (!plan_ || !buffer_ || field_index >= plan_->GetFields().size()) {
+        return nullptr;
+    }
+
+    const CompiledParsePlan::FieldOp& field = plan_->GetFields()[field_index];
+    if (!field.kernel || field.dynamic || field.element_size != width || element >= field.count) {
+        return nullptr;
+    }
+
+    const uint8_t* base = FieldAddress(field);
+    return base ? base + element * width : nullptr;
+}
+
+bool RecordView::ReadBits(size_t field_index, size_t element, size_t width, uint64_t& out) const {
+    if (!buffer_) {
+        return false;
+    }
+
+    const CompiledParsePlan::FieldOp& field = plan_->GetFields()[field_index];
+    if (field.dynamic || field.element_size != width || element >= field.count) {
+        return false;
+    }
+
+    const uint8_t* src = FieldAddress(field);
+    if (!src) {
+        return false;
+    }
+
+    if (field.count == 1) {
+        out = BitUnpack::Extract(field.bits, src);
+    } else {
+        BitUnpack::UnpackArray(&out, sizeof(out), src, field.bit_offset + element * field.bit_width,
+                               field.bit_width, 1, !field.little_endian, field.sign_extend);
+    }
+    return true;
+}
@@ -1,5 +1,7 @@
 #include "analysis_pipeline/unpacker_core/utils/reflection_based_parser.h"
 #include "analysis_pipeline/unpacker_core/utils/field_mapping_parser.h"
+#include "analysis_pipeline/unpacker_core/utils/compiled_parse_plan.h"
+#include "analysis_pipeline/unpacker_core/utils/mapping_cache.h"
 
 #include <TClass.h>
 #include <TRealData.h>
@@ -11,8 +13,12 @@
 #include <stdexcept>
 #include <algorithm>
 
-ReflectionBasedParser::ReflectionBasedParser(std::string class_name, std::string default_endianness)
-    : class_name_(std::move(class_name)), default_endianness_(std::move(default_endianness)) {
+ReflectionBasedParser::ReflectionBasedParser(std::string class_name,
+                                             std::string default_endianness,
+                                             nlohmann::json field_overrides)
+    : class_name_(std::move(class_name)),
+      default_endianness_(std::move(default_endianness)),
+      field_overrides_(std::move(field_overrides)) {
     delegate_ = new FieldMappingParser();
     BuildJsonMappingFromReflection();
 }
@@ -25,7 +31,7 @@ bool ReflectionBasedParser::Parse(const uint8_t* buffer,
                                   size_t buffer_size,
                                   size_t start_offset,
                                   TObject* obj) const {
-    return delegate_->ParseAndFill(buffer, buffer_size, start_offset, json_field_mapping_, obj);
+    return delegate_->ParseAndFill(buffer, buffer_size, start_offset, *plan_, obj);
 }
 
 void ReflectionBasedParser::BuildJsonMappingFromReflection() {
@@ -34,6 +40,28 @@ void ReflectionBasedParser::BuildJsonMappingFromReflection() {
         throw std::runtime_error("ReflectionBasedParser: Could not resolve class " + class_name_);
     }
 
+    MappingCache& cache = MappingCache::Instance();
+    if (auto cached = cache.Find(cls, default_endianness_, field_overrides_)) {
+        json_field_mapping_ = cached->mapping;
+        total_parsed_size_ = cached->total_parsed_size;
+        plan_ = cached->plan;
+        if (plan_) {
+            spdlog::debug("ReflectionBasedParser: Reusing cached mapping and plan for class '{}'", class_name_);
+            return;
+        }
+
+        // Loaded from the cache file; only the plan needs building in this process
+        plan_ = CompiledParsePlan::Compile(json_field_mapping_, cls);
+        if (plan_) {
+            auto entry = std::make_shared<MappingCache::Entry>(*cached);
+            entry->plan = plan_;
+            cache.Insert(cls, default_endianness_, field_overrides_, std::move(entry));
+            spdlog::debug("ReflectionBasedParser: Compiled cached mapping for class '{}'", class_name_);
+            return;
+        }
+        spdlog::warn("ReflectionBasedParser: Cached mapping for class '{}' no longer compiles; reflecting again", class_name_);
+    }
+
     TList* real_data = cls->GetListOfRealData();
     if (!real_data) {
         throw std::runtime_error("ReflectionBasedParser: Class " + class_name_ + " has no real data");
@@ -45,6 +73,7 @@ void ReflectionBasedParser::BuildJsonMappingFromReflection() {
     size_t total_parsed_size = 0;
 
     size_t running_offset = 0;
+    std::string anchor;  // last variable-length field; later fields are placed after it
 
     for (TIter it(real_data); TRealData* rd = static_cast<TRealData*>(it()); ) {
         const std::string name = rd->GetName();
@@ -54,32 +83,68 @@ void ReflectionBasedParser::BuildJsonMappingFromReflection() {
         if (!dm) continue;
 
         const std::string type = dm->GetTypeName();
-        if (type.find("std::") != std::string::npos || type.find("vector") != std::string::npos) {
-            spdlog::debug("Skipping STL or vector field '{}'", name);
+        auto override_it = field_overrides_.find(name);
+        const bool variable = type.compare(0, 7, "vector<") == 0 && override_it != field_overrides_.end() &&
+                              (override_it->contains("count_from") || override_it->contains("terminator"));
+
+        if (!variable && (type.find("std::") != std::string::npos || type.find("vector") != std::string::npos)) {
+            spdlog::debug("Skipping STL or vector field '{}' (override count_from or terminator to decode a vector)", name);
             continue;
         }
 
-        const size_t size = dm->GetUnitSize();
+        const size_t size = variable ? 0 : dm->GetUnitSize();
 
         nlohmann::json field_json;
         field_json["offset"] = static_cast<int64_t>(running_offset);
-        field_json["size"] = size;
+        if (!variable) {
+            field_json["size"] = size;
+        }
         field_json["endianness"] = default_endianness_;
+        if (!anchor.empty()) {
+            field_json["after"] = anchor;
+        }
 
-        json_field_mapping_[name] = std::move(field_json);
-        running_offset += size;
-    }
+        if (override_it != field_overrides_.end()) {
+            field_json.update(*override_it);
+        }
 
-    total_parsed_size = running_offset;
+        json_field_mapping_[name] = std::move(field_json);
 
+        if (variable) {
+            anchor = name;
+            running_offset = 0;
+        } else {
+            running_offset += size;
+        }
+        total_parsed_size += size;
+    }
 
     if (json_field_mapping_.empty()) {
         throw std::runtime_error("ReflectionBasedParser: No fields found for class " + class_name_);
     }
 
-    spdlog::info("ReflectionBasedParser: Constructed mapping for {} fields from class '{}', total parsed size {} bytes",
-                 json_field_mapping_.size(), class_name_, total_parsed_size);
+    plan_ = CompiledParsePlan::Compile(json_field_mapping_, cls);
+    if (!plan_) {
+        throw std::runtime_error("ReflectionBasedParser: Could not compile field mapping for class " + class_name_);
+    }
+
+    // Overrides may move or widen fields past the packed layout
+    total_parsed_size = std::max(total_parsed_size, plan_->GetRecordExtent());
+
+    spdlog::info("ReflectionBasedParser: Constructed mapping for {} fields from class '{}', total parsed size {} bytes{}",
+                 json_field_mapping_.size(), class_name_, total_parsed_size,
+                 plan_->HasVariableLength() ? " plus variable-length data" : "");
+
+    const auto& stats = plan_->GetStats();
+    spdlog::info("ReflectionBasedParser: Class '{}' decodes in {} ops, {} of {} fields coalesced into {} bulk copies",
+                 class_name_, stats.ops, stats.coalesced_fields, stats.fields, stats.coalesced_runs);
 
     total_parsed_size_ = total_parsed_size;  // store total size in member variable
+
+    auto entry = std::make_shared<MappingCache::Entry>();
+    entry->mapping = json_field_mapping_;
+    entry->total_parsed_size = total_parsed_size_;
+    entry->plan = plan_;
+    cache.Insert(cls, default_endianness_, field_overrides_, std::move(entry));
 }
 
@@ -0,0 +1,66 @@
+#include "analysis_pipeline/unpacker_core/utils/stage_metrics.h"
+
+#include <unordered_map>
+
+namespace {
+
+std::atomic<uint64_t> g_next_id{1};
+
+// Slots this thread has used, by owner id. The last one is checked first, since a thread
+// almost always records into the same stage several times in a row.
+struct ThreadSlots {
+    uint64_t last_id = 0;
+    void* last_slot = nullptr;
+    std::unordered_map<uint64_t, void*> slots;
+};
+
+thread_local ThreadSlots t_slots;
+
+} // namespace
+
+StageMetrics::StageMetrics() : id_(g_next_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+StageMetrics::~StageMetrics() = default;
+
+StageMetrics::Slot& StageMetrics::LocalSlot() {
+    if (t_slots.last_id == id_) {
+        return *static_cast<Slot*>(t_slots.last_slot);
+    }
+
+    Slot* slot;
+    auto it = t_slots.slots.find(id_);
+    if (it != t_slots.slots.end()) {
+        slot = static_cast<Slot*>(it->second);
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_.push_back(std::make_unique<Slot>());
+        slot = slots_.back().get();
+        t_slots.slots.emplace(id_, slot);
+    }
+
+    t_slots.last_id = id_;
+    t_slots.last_slot = slot;
+    return *slot;
+}
+
+void StageMetrics::RecordFieldFailure(const std::string& field) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++field_failures_[field];
+}
+
+void StageMetrics::Collect(Totals& totals) {
+    if (!kEnabled) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& slot : slots_) {
+        for (size_t i = 0; i < kNumCounters; ++i) {
+            totals.values[i] += slot->values[i].exchange(0, std::memory_order_relaxed);
+        }
+    }
+    for (const auto& [field, count] : field_failures_) {
+        totals.field_failures[field] += count;
+    }
+    field_failures_.clear();
+}
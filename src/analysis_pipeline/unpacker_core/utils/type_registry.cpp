@@ -1,7 +1,9 @@
 #include "analysis_pipeline/unpacker_core/utils/type_registry.h"
+#include "analysis_pipeline/unpacker_core/utils/byte_swap.h"
 #include <spdlog/spdlog.h>
-#include <regex>
+#include <mutex>
 #include <cstring>
+#include <limits>
 
 TypeRegistry& TypeRegistry::Instance() {
     static TypeRegistry instance;
@@ -13,16 +15,20 @@ TypeRegistry::TypeRegistry() {
     system_little_endian_ = (*reinterpret_cast<uint8_t*>(&test) == 0x1);
 
 #define REGISTER_TYPE(TYPE_NAME, CPP_TYPE) \
-    handlers_[TYPE_NAME] = [this](const uint8_t* buffer, size_t buffer_size, size_t offset, bool little_endian, TObject* obj, TDataMember* member) -> bool { \
+    handler_storage_.emplace_back([this](const uint8_t* buffer, size_t buffer_size, size_t offset, bool little_endian, TObject* obj, TDataMember* member) -> bool { \
         CPP_TYPE val; \
         if (!ReadValue<CPP_TYPE>(buffer, buffer_size, offset, little_endian, val)) { \
             spdlog::error("Failed to read value of type {} at offset {}", TYPE_NAME, offset); \
             return false; \
         } \
         return AssignValue<CPP_TYPE>(obj, member, val); \
-    }; \
+    }); \
+    handlers_[TYPE_NAME] = &handler_storage_.back(); \
     sizes_[TYPE_NAME] = sizeof(CPP_TYPE);
 
+#define REGISTER_VECTOR_TYPE(TYPE_NAME, CPP_TYPE) \
+    vector_resizers_[TYPE_NAME] = &TypeRegistry::ResizeVector<CPP_TYPE>;
+
     REGISTER_TYPE("char", int8_t)
     REGISTER_TYPE("unsigned char", uint8_t)
     REGISTER_TYPE("short", int16_t)
@@ -37,7 +43,24 @@ TypeRegistry::TypeRegistry() {
     REGISTER_TYPE("double", double)
     REGISTER_TYPE("bool", bool)
 
+    // Resizers cast to the member's exact vector type: std::vector<char> is not a
+    // std::vector<int8_t>, nor std::vector<Long64_t> a std::vector<int64_t>, even where the
+    // element sizes agree
+    REGISTER_VECTOR_TYPE("char", char)
+    REGISTER_VECTOR_TYPE("unsigned char", unsigned char)
+    REGISTER_VECTOR_TYPE("short", short)
+    REGISTER_VECTOR_TYPE("unsigned short", unsigned short)
+    REGISTER_VECTOR_TYPE("int", int)
+    REGISTER_VECTOR_TYPE("unsigned int", unsigned int)
+    REGISTER_VECTOR_TYPE("long", long)
+    REGISTER_VECTOR_TYPE("unsigned long", unsigned long)
+    REGISTER_VECTOR_TYPE("Long64_t", Long64_t)
+    REGISTER_VECTOR_TYPE("ULong64_t", ULong64_t)
+    REGISTER_VECTOR_TYPE("float", float)
+    REGISTER_VECTOR_TYPE("double", double)
+
 #undef REGISTER_TYPE
+#undef REGISTER_VECTOR_TYPE
 }
 
 size_t TypeRegistry::GetTypeSize(const std::string& type_name) const {
@@ -46,17 +69,14 @@ size_t TypeRegistry::GetTypeSize(const std::string& type_name) const {
         return it->second;
     }
 
-    std::smatch match;
-    std::regex root_array_regex(R"(array<([^,>]+),(\d+)>)");
-
-    if (std::regex_match(type_name, match, root_array_regex)) {
-        std::string base_type = match[1];
-        size_t count = std::stoul(match[2]);
-
-        base_type.erase(0, base_type.find_first_not_of(" \t"));
-        base_type.erase(base_type.find_last_not_of(" \t") + 1);
-
+    std::string base_type;
+    size_t count = 0;
+    if (ParseArrayType(type_name, base_type, count)) {
         size_t base_size = GetTypeSize(base_type);
+        if (base_size != 0 && count > std::numeric_limits<size_t>::max() / base_size) {
+            spdlog::warn("Array type '{}' is too large", type_name);
+            return 0;
+        }
         return base_size * count;
     }
 
@@ -65,34 +85,66 @@ size_t TypeRegistry::GetTypeSize(const std::string& type_name) const {
 }
 
 TypeRegistry::HandlerFunc TypeRegistry::GetHandler(const std::string& type_name) const {
+    const HandlerFunc* handler = FindHandler(type_name);
+    return handler ? *handler : nullptr;
+}
+
+const TypeRegistry::HandlerFunc* TypeRegistry::FindHandler(const std::string& type_name) const {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = handlers_.find(type_name);
+        if (it != handlers_.end()) {
+            return it->second;
+        }
+        auto resolved_it = resolved_handlers_.find(type_name);
+        if (resolved_it != resolved_handlers_.end()) {
+            return resolved_it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    // Another thread may have resolved or registered the type while we waited for the
+    // exclusive lock
     auto it = handlers_.find(type_name);
     if (it != handlers_.end()) {
         return it->second;
     }
+    auto resolved_it = resolved_handlers_.find(type_name);
+    if (resolved_it == resolved_handlers_.end()) {
+        // Misses are cached too, so an unknown type is reported once rather than per packet
+        HandlerFunc handler = ResolveArrayHandler(type_name);
+        const HandlerFunc* resolved = nullptr;
+        if (handler) {
+            resolved_storage_.push_back(std::move(handler));
+            resolved = &resolved_storage_.back();
+        }
+        resolved_it = resolved_handlers_.emplace(type_name, resolved).first;
+    }
+    return resolved_it->second;
+}
 
-    std::smatch match;
-    std::regex root_array_regex(R"(array<([^,>]+),(\d+)>)");
-
-    if (std::regex_match(type_name, match, root_array_regex)) {
-        std::string base_type = match[1];
-        size_t count = std::stoul(match[2]);
-
-        base_type.erase(0, base_type.find_first_not_of(" \t"));
-        base_type.erase(base_type.find_last_not_of(" \t") + 1);
-
+TypeRegistry::HandlerFunc TypeRegistry::ResolveArrayHandler(const std::string& type_name) const {
+    std::string base_type;
+    size_t count = 0;
+    if (ParseArrayType(type_name, base_type, count)) {
         size_t element_size = GetTypeSize(base_type);
         if (element_size == 0) {
             spdlog::warn("Unknown size for base type '{}'", base_type);
             return nullptr;
         }
+        if (count > std::numeric_limits<size_t>::max() / element_size) {
+            spdlog::warn("Array type '{}' is too large", type_name);
+            return nullptr;
+        }
 
-        return [count, element_size, base_type, this](
+        return [count, element_size, this](
             const uint8_t* buffer, size_t buffer_size,
             size_t offset, bool little_endian,
             TObject* obj, TDataMember* member) -> bool {
 
             size_t total_size = count * element_size;
-            if (offset + total_size > buffer_size) {
+            if (offset > buffer_size || total_size > buffer_size - offset) {
                 spdlog::error("Buffer too small for array '{}', needed {} bytes but buffer size is {}", 
                               member->GetName(), total_size, buffer_size - offset);
                 return false;
@@ -104,12 +156,7 @@ TypeRegistry::HandlerFunc TypeRegistry::GetHandler(const std::string& type_name)
             if (little_endian == system_little_endian_) {
                 std::memcpy(member_ptr, buffer + offset, total_size);
             } else {
-                for (size_t i = 0; i < count; ++i) {
-                    const uint8_t* src = buffer + offset + i * element_size;
-                    char* dst = member_ptr + i * element_size;
-                    std::memcpy(dst, src, element_size);
-                    SwapBytes(dst, element_size);
-                }
+                ByteSwap::SwapArray(member_ptr, buffer + offset, element_size, count);
             }
 
             return true;
@@ -121,12 +168,145 @@ TypeRegistry::HandlerFunc TypeRegistry::GetHandler(const std::string& type_name)
 }
 
 void TypeRegistry::RegisterHandler(const std::string& type_name, HandlerFunc handler) {
-    handlers_[type_name] = std::move(handler);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    // The previous handler stays in storage for plans that already resolved it; handlers_
+    // takes precedence over resolved_handlers_, so a stale array entry is simply shadowed
+    handler_storage_.push_back(std::move(handler));
+    handlers_[type_name] = &handler_storage_.back();
+    custom_types_.insert(type_name);
 }
 
-void TypeRegistry::SwapBytes(void* data, size_t size) {
-    uint8_t* bytes = static_cast<uint8_t*>(data);
-    for (size_t i = 0; i < size / 2; ++i) {
-        std::swap(bytes[i], bytes[size - 1 - i]);
+bool TypeRegistry::HasCustomHandler(const std::string& type_name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return custom_types_.count(type_name) > 0;
+}
+
+bool TypeRegistry::ResolveLayout(const std::string& type_name, size_t& element_size, size_t& count) const {
+    auto it = sizes_.find(type_name);
+    if (it != sizes_.end()) {
+        element_size = it->second;
+        count = 1;
+        return true;
+    }
+
+    std::string base_type;
+    size_t array_count = 0;
+    if (ParseArrayType(type_name, base_type, array_count)) {
+        auto base_it = sizes_.find(base_type);
+        if (base_it == sizes_.end() || array_count > std::numeric_limits<size_t>::max() / base_it->second) {
+            return false;
+        }
+        element_size = base_it->second;
+        count = array_count;
+        return true;
     }
+
+    return false;
 }
+
+bool TypeRegistry::ResolveVectorLayout(const std::string& type_name,
+                                       size_t& element_size,
+                                       VectorResize& resize) const {
+    // ROOT spells std::vector members "vector<BASE>"
+    static const std::string kPrefix = "vector<";
+    if (type_name.size() <= kPrefix.size() + 1 ||
+        type_name.compare(0, kPrefix.size(), kPrefix) != 0 ||
+        type_name.back() != '>') {
+        return false;
+    }
+
+    const size_t base_begin = type_name.find_first_not_of(" \t", kPrefix.size());
+    const size_t base_end = type_name.find_last_not_of(" \t", type_name.size() - 2);
+    if (base_begin == std::string::npos || base_end == std::string::npos || base_end < base_begin) {
+        return false;
+    }
+    const std::string base_type = type_name.substr(base_begin, base_end - base_begin + 1);
+
+    auto it = vector_resizers_.find(base_type);
+    if (it == vector_resizers_.end()) {
+        return false;
+    }
+    element_size = sizes_.at(base_type);
+    resize = it->second;
+    return true;
+}
+
+bool TypeRegistry::ParseArrayType(const std::string& type_name, std::string& base_type, size_t& count) {
+    // Accepts ROOT's spelling of std::array members, "array<BASE,N>"
+    static const std::string kPrefix = "array<";
+    if (type_name.size() <= kPrefix.size() + 2 ||
+        type_name.compare(0, kPrefix.size(), kPrefix) != 0 ||
+        type_name.back() != '>') {
+        return false;
+    }
+
+    const size_t comma = type_name.find(',', kPrefix.size());
+    if (comma == std::string::npos) {
+        return false;
+    }
+
+    const size_t base_begin = type_name.find_first_not_of(" \t", kPrefix.size());
+    if (base_begin >= comma) {
+        return false;
+    }
+    size_t base_end = comma;
+    while (base_end > base_begin && (type_name[base_end - 1] == ' ' || type_name[base_end - 1] == '\t')) {
+        --base_end;
+    }
+    if (type_name.find_first_of("<>", base_begin) < base_end) {
+        return false;
+    }
+
+    const size_t digits_end = type_name.size() - 1;
+    if (comma + 1 >= digits_end) {
+        return false;
+    }
+    size_t value = 0;
+    for (size_t i = comma + 1; i < digits_end; ++i) {
+        const char c = type_name[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        const size_t digit = static_cast<size_t>(c - '0');
+        if (value > (std::numeric_limits<size_t>::max() - digit) / 10) {
+            return false;  // N does not fit size_t
+        }
+        value = value * 10 + digit;
+    }
+
+    base_type.assign(type_name, base_begin, base_end - base_begin);
+    count = value;
+    return true;
+}
+
+namespace {
+
+template<size_t W>
+void CopyElements(void* dst, const uint8_t* src, size_t count) {
+    std::memcpy(dst, src, W * count);
+}
+
+void SwapElements16(void* dst, const uint8_t* src, size_t count) {
+    ByteSwap::SwapArray16(dst, src, count);
+}
+
+void SwapElements32(void* dst, const uint8_t* src, size_t count) {
+    ByteSwap::SwapArray32(dst, src, count);
+}
+
+void SwapElements64(void* dst, const uint8_t* src, size_t count) {
+    ByteSwap::SwapArray64(dst, src, count);
+}
+
+} // namespace
+
+TypeRegistry::CopyKernel TypeRegistry::GetCopyKernel(size_t element_size, bool swap) {
+    switch (element_size) {
+        case 1: return &CopyElements<1>;
+        case 2: return swap ? &SwapElements16 : &CopyElements<2>;
+        case 4: return swap ? &SwapElements32 : &CopyElements<4>;
+        case 8: return swap ? &SwapElements64 : &CopyElements<8>;
+        default: return nullptr;
+    }
+}
+
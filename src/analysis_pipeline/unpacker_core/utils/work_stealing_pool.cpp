@@ -0,0 +1,140 @@
+#include "analysis_pipeline/unpacker_core/utils/work_stealing_pool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(size_t num_threads) {
+    const size_t total = std::max<size_t>(1, num_threads);
+    for (size_t i = 0; i < total; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i + 1 < total; ++i) {
+        workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::ParallelFor(size_t count, size_t min_chunk, const RangeFunc& fn) {
+    if (count == 0) {
+        return;
+    }
+
+    min_chunk = std::max<size_t>(1, min_chunk);
+    const size_t threads = queues_.size();
+    if (threads == 1 || count < 2 * min_chunk) {
+        fn(0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> job_lock(job_mutex_);
+
+    // A few chunks per thread leaves room for stealing when records decode unevenly
+    const size_t chunks = std::max<size_t>(1, std::min(count / min_chunk, threads * 4));
+    const size_t chunk_size = (count + chunks - 1) / chunks;
+    const size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+
+    // Published before any range so that a worker popping a range always sees this job
+    job_.store(&fn);
+    error_ = nullptr;
+    pending_.store(num_chunks);
+
+    size_t q = 0;
+    for (size_t begin = 0; begin < count; begin += chunk_size, q = (q + 1) % threads) {
+        Queue& queue = *queues_[q];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.ranges.emplace_back(begin, std::min(count, begin + chunk_size));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        ++generation_;
+    }
+    wake_cv_.notify_all();
+
+    const size_t caller_index = threads - 1;
+    while (RunOne(caller_index)) {
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        done_cv_.wait(lock, [this] { return pending_.load() == 0; });
+    }
+    job_.store(nullptr);
+
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void WorkStealingPool::WorkerLoop(size_t index) {
+    size_t seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        while (RunOne(index)) {
+        }
+    }
+}
+
+bool WorkStealingPool::RunOne(size_t index) {
+    std::pair<size_t, size_t> range;
+    if (!PopLocal(index, range) && !Steal(index, range)) {
+        return false;
+    }
+
+    try {
+        (*job_.load())(range.first, range.second);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+
+    if (pending_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        done_cv_.notify_all();
+    }
+    return true;
+}
+
+bool WorkStealingPool::PopLocal(size_t index, std::pair<size_t, size_t>& range) {
+    Queue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty()) {
+        return false;
+    }
+    range = queue.ranges.back();
+    queue.ranges.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::Steal(size_t thief, std::pair<size_t, size_t>& range) {
+    const size_t n = queues_.size();
+    for (size_t k = 1; k < n; ++k) {
+        Queue& victim = *queues_[(thief + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}